@@ -0,0 +1,191 @@
+#include "solution.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace solution {
+    // Local search over a valid plan. Every move replaces a set of
+    // rectangles by another set with the same XOR, so the plan stays valid
+    // after every step and the current plan is always the best one found.
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        // Largest window handed to solve_exact().
+        const int WINDOW_CELLS = 64;
+        // Most rectangles re-solved together in one window.
+        const int WINDOW_GROUP = 6;
+
+        // XOR of two column (or row) intervals when it is a single interval.
+        // Returns 0 when they cancel, 1 when [lo, hi] is the result, and -1
+        // otherwise.
+        int interval_xor(int a1, int a2, int b1, int b2, int& lo, int& hi) {
+            if (a1 == b1 && a2 == b2) return 0;
+            if (a2 + 1 == b1) { lo = a1; hi = b2; return 1; }
+            if (b2 + 1 == a1) { lo = b1; hi = a2; return 1; }
+            if (a1 == b1) { lo = min(a2, b2) + 1; hi = max(a2, b2); return 1; }
+            if (a2 == b2) { lo = min(a1, b1); hi = max(a1, b1) - 1; return 1; }
+            return -1;
+        }
+
+        // Flips that `a ^ b` can be written with when it is at most one
+        // rectangle (stored in out); -1 otherwise.
+        int merge_pair(const Rect& a, const Rect& b, Rect& out) {
+            int lo, hi, kind;
+            if (a.r1 == b.r1 && a.r2 == b.r2) {
+                kind = interval_xor(a.c1, a.c2, b.c1, b.c2, lo, hi);
+                if (kind == 1) out = {a.r1, lo, a.r2, hi};
+                return kind;
+            }
+            if (a.c1 == b.c1 && a.c2 == b.c2) {
+                kind = interval_xor(a.r1, a.r2, b.r1, b.r2, lo, hi);
+                if (kind == 1) out = {lo, a.c1, hi, a.c2};
+                return kind;
+            }
+            return -1;
+        }
+
+        struct LocalSearch {
+            vector<Rect>& plan;
+            Clock::time_point deadline;
+            mt19937 rng;
+            const function<void(const Plan&)>& on_improve;
+            // corner_lower_bound() of the matrix; no plan can be smaller.
+            size_t bound;
+
+            bool expired() const { return Clock::now() >= deadline; }
+            bool at_bound() const { return plan.size() <= bound; }
+            bool finished() const { return at_bound() || expired(); }
+
+            double remaining_ms() const {
+                return std::chrono::duration<double, std::milli>(deadline - Clock::now()).count();
+            }
+
+            bool has_window_seed() const {
+                for (const Rect& r : plan) {
+                    if ((r.r2 - r.r1 + 1) * (r.c2 - r.c1 + 1) <= WINDOW_CELLS) return true;
+                }
+                return false;
+            }
+
+            // Report the new plan; false once it reaches the bound.
+            bool improved() {
+                if (on_improve) on_improve(Plan{static_cast<int>(plan.size()), plan});
+                return !at_bound();
+            }
+
+            // Merge pairs whose XOR is one rectangle or nothing, until no
+            // pair merges. Returns false when the deadline hit or the plan
+            // reached the bound first.
+            bool merge_pairs() {
+                bool changed = true;
+                while (changed) {
+                    changed = false;
+                    for (size_t i = 0; i < plan.size(); ++i) {
+                        if ((i & 63) == 0 && expired()) return false;
+                        for (size_t j = i + 1; j < plan.size(); ++j) {
+                            Rect merged;
+                            int kind = merge_pair(plan[i], plan[j], merged);
+                            if (kind < 0) continue;
+                            plan.erase(plan.begin() + j);
+                            if (kind == 0) plan.erase(plan.begin() + i);
+                            else plan[i] = merged;
+                            changed = true;
+                            if (!improved()) return false;
+                            break;
+                        }
+                    }
+                }
+                return true;
+            }
+
+            // Pick a random rectangle, grow a group of nearby rectangles
+            // whose bounding box stays within WINDOW_CELLS, and replace the
+            // group by an optimal cover of its XOR inside that box.
+            bool improve_window() {
+                size_t seed = rng() % plan.size();
+                Rect box = plan[seed];
+                long long seed_area = static_cast<long long>(box.r2 - box.r1 + 1) * (box.c2 - box.c1 + 1);
+                if (seed_area > WINDOW_CELLS) return false;
+
+                vector<size_t> order(plan.size());
+                for (size_t k = 0; k < order.size(); ++k) order[k] = k;
+                shuffle(order.begin(), order.end(), rng);
+
+                vector<size_t> group{seed};
+                for (size_t k : order) {
+                    if (k == seed || static_cast<int>(group.size()) >= WINDOW_GROUP) continue;
+                    const Rect& r = plan[k];
+                    Rect grown{min(box.r1, r.r1), min(box.c1, r.c1),
+                               max(box.r2, r.r2), max(box.c2, r.c2)};
+                    long long area = static_cast<long long>(grown.r2 - grown.r1 + 1) *
+                                     (grown.c2 - grown.c1 + 1);
+                    if (area > WINDOW_CELLS) continue;
+                    box = grown;
+                    group.push_back(k);
+                }
+                if (group.size() < 2) return false;
+
+                int h = box.r2 - box.r1 + 1;
+                int w = box.c2 - box.c1 + 1;
+                vector<vector<bool>> residual(h, vector<bool>(w, false));
+                for (size_t k : group) {
+                    const Rect& r = plan[k];
+                    for (int i = r.r1; i <= r.r2; ++i) {
+                        for (int j = r.c1; j <= r.c2; ++j) {
+                            residual[i - box.r1][j - box.c1] = !residual[i - box.r1][j - box.c1];
+                        }
+                    }
+                }
+
+                // The exact search must not outlive the call's deadline.
+                ExactOptions budget;
+                budget.node_budget = 20000;
+                budget.time_budget_ms = remaining_ms();
+                if (budget.time_budget_ms <= 0) return false;
+                ExactResult best = solve_exact(h, w, residual, budget);
+                if (best.flips >= static_cast<int>(group.size())) return false;
+
+                sort(group.rbegin(), group.rend());
+                for (size_t k : group) plan.erase(plan.begin() + k);
+                for (const Rect& r : best.rects) {
+                    plan.push_back({r.r1 + box.r1, r.c1 + box.c1, r.r2 + box.r1, r.c2 + box.c1});
+                }
+                improved();
+                return true;
+            }
+        };
+    }
+
+    Plan solve_anytime(int m, int n, const vector<vector<bool>>& matrix,
+                      const AnytimeOptions& options){
+        Clock::time_point deadline = Clock::now() +
+            std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::milli>(options.deadline_ms));
+
+        Plan plan = solve_with_plan(m, n, matrix, options.greedy);
+        if (options.on_improve) options.on_improve(plan);
+        if (plan.rects.size() < 2 || Clock::now() >= deadline) return plan;
+        // Nothing beats the corner-parity bound, so reaching it ends the
+        // search at any point.
+        size_t bound = static_cast<size_t>(corner_lower_bound(m, n, matrix));
+        if (plan.rects.size() <= bound) return plan;
+
+        LocalSearch search{plan.rects, deadline, mt19937(options.seed), options.on_improve, bound};
+        if (search.merge_pairs()) {
+            // Window moves can enable new merges; alternate until time is up.
+            while (plan.rects.size() >= 2 && search.has_window_seed() && !search.finished()) {
+                for (int attempt = 0; attempt < 64 && plan.rects.size() >= 2; ++attempt) {
+                    if (search.finished()) break;
+                    search.improve_window();
+                }
+                if (search.finished() || !search.merge_pairs()) break;
+            }
+        }
+        plan.flips = static_cast<int>(plan.rects.size());
+        return plan;
+    }
+}
@@ -0,0 +1,57 @@
+#include "solution.h"
+#include "greedy.h"
+#include <exception>
+#include <vector>
+
+using namespace std;
+
+namespace solution {
+    static void add_stats(SolveStats& total, const SolveStats& part){
+        total.iterations += part.iterations;
+        total.candidates_scanned += part.candidates_scanned;
+        total.candidates_skipped += part.candidates_skipped;
+        total.build_pref_ns += part.build_pref_ns;
+        total.score_ns += part.score_ns;
+        total.flip_ns += part.flip_ns;
+        total.best_cover.insert(total.best_cover.end(),
+                                part.best_cover.begin(), part.best_cover.end());
+    }
+
+    vector<int> solve_batch(const vector<vector<vector<bool>>>& matrices,
+                            const SolveOptions& options){
+        vector<int> results(matrices.size(), 0);
+        if (matrices.empty()) return results;
+
+        // Jobs are distributed over the pool; each scan inside a job is
+        // serial. Every worker owns one Scratch for the whole batch.
+        ThreadPool pool(options.threads);
+        vector<Scratch> scratch(pool.size());
+        vector<exception_ptr> errors(matrices.size());
+        // Each job fills its own stats; they are summed in input order
+        // once the pool has joined, so workers never share one.
+        vector<SolveStats> job_stats(STATS_ENABLED && options.stats ? matrices.size() : 0);
+
+        pool.parallel_for(static_cast<int>(matrices.size()), [&](int job, int worker){
+            const vector<vector<bool>>& matrix = matrices[job];
+            int m = static_cast<int>(matrix.size());
+            int n = m ? static_cast<int>(matrix[0].size()) : 0;
+            SolveOptions job_options = options;
+            job_options.stats = STATS_ENABLED && options.stats ? &job_stats[job] : nullptr;
+            try {
+                load_matrix(m, n, matrix, scratch[worker].bits);
+                results[job] = solve_packed(scratch[worker], job_options, nullptr);
+            } catch (...) {
+                errors[job] = current_exception();
+            }
+        });
+
+        if (STATS_ENABLED && options.stats) {
+            *options.stats = SolveStats();
+            for (const SolveStats& part : job_stats) add_stats(*options.stats, part);
+        }
+        for (const exception_ptr& error : errors) {
+            if (error) rethrow_exception(error);
+        }
+        return results;
+    }
+}
@@ -0,0 +1,283 @@
+// Benchmark suite for the rectangle cover solver.
+//
+//   g++ -O2 -std=c++17 -pthread bench.cpp solution.cpp row_max.cpp sparse.cpp -o bench
+//   ./bench [--quick] [--out results.csv]
+//
+// Runs every generator over a grid of sizes and densities for each strategy
+// and scoring rule and writes one CSV row per configuration:
+//   generator,strategy,scoring,rows,cols,density,seed,ones,lower_bound,
+//   reduced_cells,iterations,flips,ms,ns_per_candidate,peak_heap_bytes
+// `lower_bound` is corner_lower_bound(), against which `flips` can be
+// judged without an exact search. The "sparse_list" rows time
+// solve_sparse() on the set-cell list (built outside the timer), only for
+// densities up to 5%, with ns_per_candidate left at 0. `reduced_cells` is
+// m * n after merging equal adjacent rows and columns; the "_dedup" rows
+// solve with SolveOptions::dedup and count candidates on that matrix;
+// the "_coarse" rows solve with SolveOptions::coarse_block = 8.
+// `ns_per_candidate` divides the solve time by the number of rectangles the
+// strategy enumerates (every (r1, c1, r2, c2) per iteration for EXHAUSTIVE,
+// one histogram cell per iteration for MAXIMAL, one anchor per iteration
+// for LAZY, one partner row per iteration for CORNER, plus the rectangles
+// of every anchor re-scanned under NET_GAIN only with stats). Build with
+// -DRECT_COVER_STATS to use the solver's own counters instead; the timing
+// then includes the cost of collecting them. `peak_heap_bytes` is the
+// high-water mark of live heap memory during that solve() call alone.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include <malloc.h>
+#include "solution.h"
+
+using namespace solution;
+
+// ---------------------------- Heap accounting -------------------------------
+
+static std::atomic<size_t> g_live_bytes{0};
+static std::atomic<size_t> g_peak_bytes{0};
+
+static void* note_alloc(void* p) {
+    if (!p) throw std::bad_alloc();
+    size_t now = g_live_bytes += malloc_usable_size(p);
+    size_t peak = g_peak_bytes.load();
+    while (now > peak && !g_peak_bytes.compare_exchange_weak(peak, now)) {}
+    return p;
+}
+
+static void note_free(void* p) {
+    if (!p) return;
+    g_live_bytes -= malloc_usable_size(p);
+    std::free(p);
+}
+
+void* operator new(size_t size) { return note_alloc(std::malloc(size ? size : 1)); }
+void* operator new(size_t size, std::align_val_t align) {
+    size_t a = static_cast<size_t>(align);
+    return note_alloc(std::aligned_alloc(a, (std::max<size_t>(size, 1) + a - 1) / a * a));
+}
+void operator delete(void* p) noexcept { note_free(p); }
+void operator delete(void* p, size_t) noexcept { note_free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { note_free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { note_free(p); }
+
+// ------------------------------- Generators ---------------------------------
+
+using Matrix = vector<vector<bool>>;
+
+static Matrix random_matrix(int m, int n, double density, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::bernoulli_distribution bit(density);
+    Matrix matrix(m, vector<bool>(n));
+    for (auto& row : matrix) {
+        for (size_t j = 0; j < row.size(); ++j) row[j] = bit(rng);
+    }
+    return matrix;
+}
+
+// Exactly round(density * m * n) ones at distinct random positions.
+static Matrix sparse_matrix(int m, int n, double density, unsigned seed) {
+    std::mt19937 rng(seed);
+    vector<int> cells(static_cast<size_t>(m) * n);
+    for (size_t k = 0; k < cells.size(); ++k) cells[k] = static_cast<int>(k);
+    std::shuffle(cells.begin(), cells.end(), rng);
+    size_t ones = static_cast<size_t>(density * cells.size() + 0.5);
+    Matrix matrix(m, vector<bool>(n));
+    for (size_t k = 0; k < ones && k < cells.size(); ++k) {
+        matrix[cells[k] / n][cells[k] % n] = true;
+    }
+    return matrix;
+}
+
+static Matrix diagonal_matrix(int m, int n, double, unsigned) {
+    Matrix matrix(m, vector<bool>(n));
+    for (int i = 0; i < m; ++i) matrix[i][static_cast<long long>(i) * n / m] = true;
+    return matrix;
+}
+
+static Matrix checkerboard_matrix(int m, int n, double, unsigned) {
+    Matrix matrix(m, vector<bool>(n));
+    for (int i = 0; i < m; ++i) {
+        for (int j = 0; j < n; ++j) matrix[i][j] = (i + j) % 2 == 0;
+    }
+    return matrix;
+}
+
+// XOR of random rectangles; more rectangles at higher density.
+static Matrix blocky_matrix(int m, int n, double density, unsigned seed) {
+    std::mt19937 rng(seed);
+    Matrix matrix(m, vector<bool>(n));
+    int blocks = std::max(1, static_cast<int>(density * 20));
+    for (int b = 0; b < blocks; ++b) {
+        int r1 = rng() % m, r2 = rng() % m;
+        int c1 = rng() % n, c2 = rng() % n;
+        if (r1 > r2) std::swap(r1, r2);
+        if (c1 > c2) std::swap(c1, c2);
+        for (int i = r1; i <= r2; ++i) {
+            for (int j = c1; j <= c2; ++j) matrix[i][j] = !matrix[i][j];
+        }
+    }
+    return matrix;
+}
+
+struct Generator {
+    const char* name;
+    Matrix (*make)(int, int, double, unsigned);
+    vector<double> densities;
+};
+
+// -------------------------------- Harness -----------------------------------
+
+struct StrategyRun {
+    const char* name;
+    Strategy strategy;
+    Scoring scoring;
+    vector<int> sizes;
+    // Solve from the coordinate list with solve_sparse() instead.
+    bool coordinates = false;
+    bool dedup = false;
+    int coarse_block = 0;
+};
+
+// Rows and columns left after merging equal adjacent ones, as
+// SolveOptions::dedup does.
+static void reduced_size(const Matrix& matrix, int& rows, int& cols) {
+    vector<size_t> kept;
+    for (size_t i = 0; i < matrix.size(); ++i) {
+        if (i == 0 || matrix[i] != matrix[i - 1]) kept.push_back(i);
+    }
+    rows = static_cast<int>(kept.size());
+    cols = 0;
+    size_t n = matrix.empty() ? 0 : matrix[0].size();
+    for (size_t j = 0; j < n; ++j) {
+        bool differs = j == 0;
+        for (size_t k = 0; k < kept.size() && !differs; ++k) {
+            differs = matrix[kept[k]][j] != matrix[kept[k]][j - 1];
+        }
+        cols += differs;
+    }
+}
+
+static double candidates_per_iteration(Strategy strategy, int m, int n) {
+    if (strategy == Strategy::CORNER) return m;
+    if (strategy != Strategy::EXHAUSTIVE) return static_cast<double>(m) * n;
+    return (m * (m + 1.0) / 2.0) * (n * (n + 1.0) / 2.0);
+}
+
+int main(int argc, char** argv) {
+    bool quick = false;
+    const char* out_path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--quick")) quick = true;
+        else if (!std::strcmp(argv[i], "--out") && i + 1 < argc) out_path = argv[++i];
+        else {
+            std::fprintf(stderr, "usage: bench [--quick] [--out FILE]\n");
+            return 2;
+        }
+    }
+    FILE* out = out_path ? std::fopen(out_path, "w") : stdout;
+    if (!out) {
+        std::perror(out_path);
+        return 1;
+    }
+
+    const vector<Generator> generators = {
+        {"random",       random_matrix,       {0.1, 0.5, 0.9}},
+        {"sparse",       sparse_matrix,       {0.005, 0.01, 0.05}},
+        {"diagonal",     diagonal_matrix,     {0.0}},
+        {"checkerboard", checkerboard_matrix, {0.5}},
+        {"blocky",       blocky_matrix,       {0.1, 0.5}},
+    };
+    const vector<StrategyRun> strategies = quick
+        ? vector<StrategyRun>{
+              {"exhaustive", Strategy::EXHAUSTIVE, Scoring::COVER, {8, 16}},
+              {"exhaustive", Strategy::EXHAUSTIVE, Scoring::NET_GAIN, {8, 16}},
+              {"lazy", Strategy::LAZY, Scoring::COVER, {8, 16, 64}},
+              {"lazy", Strategy::LAZY, Scoring::NET_GAIN, {8, 16, 64}},
+              {"maximal", Strategy::MAXIMAL, Scoring::COVER, {8, 16, 64}},
+              {"corner", Strategy::CORNER, Scoring::COVER, {8, 16, 64, 256}},
+              {"sparse_list", Strategy::EXHAUSTIVE, Scoring::NET_GAIN, {64, 256}, true},
+              {"lazy_dedup", Strategy::LAZY, Scoring::COVER, {8, 16, 64}, false, true},
+              {"lazy_coarse", Strategy::LAZY, Scoring::NET_GAIN, {64}, false, false, 8},
+              {"maximal_coarse", Strategy::MAXIMAL, Scoring::COVER, {64}, false, false, 8}}
+        : vector<StrategyRun>{
+              {"exhaustive", Strategy::EXHAUSTIVE, Scoring::COVER, {8, 16, 32, 48}},
+              {"exhaustive", Strategy::EXHAUSTIVE, Scoring::NET_GAIN, {8, 16, 32, 48}},
+              {"lazy", Strategy::LAZY, Scoring::COVER, {8, 16, 32, 48, 128}},
+              {"lazy", Strategy::LAZY, Scoring::NET_GAIN, {8, 16, 32, 48, 128}},
+              {"maximal", Strategy::MAXIMAL, Scoring::COVER, {8, 16, 32, 48, 128, 256}},
+              {"corner", Strategy::CORNER, Scoring::COVER, {8, 16, 32, 48, 128, 256, 1024}},
+              {"sparse_list", Strategy::EXHAUSTIVE, Scoring::NET_GAIN, {64, 256, 1024, 4096}, true},
+              {"lazy_dedup", Strategy::LAZY, Scoring::COVER, {8, 16, 32, 48, 128}, false, true},
+              {"lazy_coarse", Strategy::LAZY, Scoring::NET_GAIN, {32, 48, 128}, false, false, 8},
+              {"maximal_coarse", Strategy::MAXIMAL, Scoring::COVER, {32, 48, 128, 256}, false, false, 8}};
+    const unsigned seed = 20240601u;
+
+    std::fprintf(out, "generator,strategy,scoring,rows,cols,density,seed,ones,lower_bound,"
+                      "reduced_cells,iterations,flips,ms,ns_per_candidate,peak_heap_bytes\n");
+    for (const StrategyRun& run : strategies) {
+        SolveOptions options;
+        options.strategy = run.strategy;
+        options.scoring = run.scoring;
+        options.dedup = run.dedup;
+        options.coarse_block = run.coarse_block;
+        const char* scoring = run.scoring == Scoring::NET_GAIN ? "net_gain" : "cover";
+        SolveStats stats;
+        options.stats = &stats;
+        for (const Generator& gen : generators) {
+            for (int size : run.sizes) {
+                for (double density : gen.densities) {
+                    if (run.coordinates && density > 0.05) continue;
+                    Matrix matrix = gen.make(size, size, density, seed + size);
+                    size_t ones = 0;
+                    for (const auto& row : matrix) ones += std::count(row.begin(), row.end(), true);
+                    int lower_bound = corner_lower_bound(size, size, matrix);
+                    int reduced_rows, reduced_cols;
+                    reduced_size(matrix, reduced_rows, reduced_cols);
+                    vector<Cell> cells;
+                    if (run.coordinates) {
+                        for (int i = 0; i < size; ++i) {
+                            for (int j = 0; j < size; ++j) {
+                                if (matrix[i][j]) cells.push_back({i, j});
+                            }
+                        }
+                    }
+
+                    g_peak_bytes = g_live_bytes.load();
+                    size_t base = g_live_bytes.load();
+                    auto start = std::chrono::steady_clock::now();
+                    int flips = run.coordinates ? solve_sparse(size, size, cells).flips
+                                                : solve(size, size, matrix, options);
+                    auto stop = std::chrono::steady_clock::now();
+                    size_t peak = g_peak_bytes.load() - base;
+
+                    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+                    int iterations = flips;
+                    int scanned_rows = run.dedup ? reduced_rows : size;
+                    int scanned_cols = run.dedup ? reduced_cols : size;
+                    double candidates = candidates_per_iteration(run.strategy, scanned_rows,
+                                                                 scanned_cols) * iterations;
+                    // solve_sparse() does not report its candidates.
+                    if (run.coordinates) candidates = 0;
+                    else if (STATS_ENABLED) {
+                        iterations = static_cast<int>(stats.iterations);
+                        candidates = static_cast<double>(stats.candidates_scanned);
+                    }
+                    std::fprintf(out, "%s,%s,%s,%d,%d,%g,%u,%zu,%d,%d,%d,%d,%.3f,%.3f,%zu\n",
+                                 gen.name, run.name, scoring, size, size, density,
+                                 seed + size, ones, lower_bound, reduced_rows * reduced_cols,
+                                 iterations, flips, ns / 1e6,
+                                 candidates > 0 ? ns / candidates : 0.0, peak);
+                    std::fflush(out);
+                }
+            }
+        }
+    }
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
@@ -0,0 +1,188 @@
+#ifndef BIT_MATRIX_H
+#define BIT_MATRIX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace solution {
+
+// Minimal allocator handing out storage aligned to `Align` bytes so that
+// every packed matrix starts on a cache-line boundary.
+template <typename T, std::size_t Align>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = AlignedAllocator<U, Align>; };
+
+    AlignedAllocator() noexcept = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Align>&) noexcept {}
+
+    T* allocate(std::size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Align)));
+    }
+    void deallocate(T* p, std::size_t) noexcept {
+        ::operator delete(p, std::align_val_t(Align));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Align>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Align>&) const noexcept { return false; }
+};
+
+// Row-major bit matrix packed into 64-bit words. Every row starts on a word
+// boundary; bits past `cols()` in the last word of a row are kept at zero so
+// whole-word operations (popcount, any) never see garbage. The words are
+// either owned or, after attach(), the caller's.
+class BitMatrix {
+public:
+    static constexpr int WORD_BITS = 64;
+
+    BitMatrix() = default;
+    BitMatrix(int rows, int cols) { reset(rows, cols); }
+
+    // Resize to rows x cols and clear every bit. Keeps the allocated capacity.
+    void reset(int rows, int cols) {
+        rows_ = rows;
+        cols_ = cols;
+        stride_ = (static_cast<std::size_t>(cols) + WORD_BITS - 1) / WORD_BITS;
+        external_ = nullptr;
+        words_.assign(static_cast<std::size_t>(rows) * stride_, 0);
+    }
+
+    // Copy rows x cols bits from packed rows `stride` words apart, one
+    // memcpy per row. Bits past `cols` in the source are dropped.
+    void load(const uint64_t* words, int rows, int cols, std::size_t stride) {
+        rows_ = rows;
+        cols_ = cols;
+        stride_ = (static_cast<std::size_t>(cols) + WORD_BITS - 1) / WORD_BITS;
+        external_ = nullptr;
+        words_.resize(static_cast<std::size_t>(rows) * stride_);
+        if (stride_ == 0) return;
+        const uint64_t tail = tail_mask();
+        for (int r = 0; r < rows; ++r) {
+            uint64_t* dst = row(r);
+            std::memcpy(dst, words + static_cast<std::size_t>(r) * stride, stride_ * sizeof(uint64_t));
+            dst[stride_ - 1] &= tail;
+        }
+    }
+
+    // Pack rows x cols bytes from rows `stride` bytes apart; any nonzero
+    // byte is a set bit.
+    void load_bytes(const uint8_t* data, int rows, int cols, std::size_t stride) {
+        reset(rows, cols);
+        for (int r = 0; r < rows; ++r) {
+            const uint8_t* src = data + static_cast<std::size_t>(r) * stride;
+            uint64_t* dst = row(r);
+            for (int c = 0; c < cols; ++c) {
+                dst[c / WORD_BITS] |= uint64_t(src[c] != 0) << (c % WORD_BITS);
+            }
+        }
+    }
+
+    // Work on the caller's rows x cols bits, rows `stride` words apart,
+    // without copying them. Padding bits past `cols` are cleared. The
+    // memory must outlive every use until the next reset(), load() or
+    // attach(). Owned capacity is kept for later calls.
+    void attach(uint64_t* words, int rows, int cols, std::size_t stride) {
+        rows_ = rows;
+        cols_ = cols;
+        stride_ = stride;
+        external_ = words;
+        const std::size_t used = (static_cast<std::size_t>(cols) + WORD_BITS - 1) / WORD_BITS;
+        for (int r = 0; r < rows && stride > 0; ++r) {
+            uint64_t* p = row(r);
+            if (used > 0) p[used - 1] &= tail_mask();
+            for (std::size_t k = used; k < stride; ++k) p[k] = 0;
+        }
+    }
+
+    // Clear every bit in place.
+    void clear() {
+        for (int r = 0; r < rows_; ++r) std::memset(row(r), 0, stride_ * sizeof(uint64_t));
+    }
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    std::size_t stride() const { return stride_; }
+    // Bytes of owned storage allocated; attached words are not counted.
+    std::size_t capacity_bytes() const { return words_.capacity() * sizeof(uint64_t); }
+
+    uint64_t* row(int r) { return data() + static_cast<std::size_t>(r) * stride_; }
+    const uint64_t* row(int r) const { return data() + static_cast<std::size_t>(r) * stride_; }
+
+    bool get(int r, int c) const {
+        return (row(r)[c / WORD_BITS] >> (c % WORD_BITS)) & 1u;
+    }
+
+    void set(int r, int c, bool v) {
+        uint64_t bit = uint64_t(1) << (c % WORD_BITS);
+        uint64_t& w = row(r)[c / WORD_BITS];
+        w = v ? (w | bit) : (w & ~bit);
+    }
+
+    bool any() const {
+        for (int r = 0; r < rows_; ++r) {
+            const uint64_t* p = row(r);
+            for (std::size_t k = 0; k < stride_; ++k) {
+                if (p[k]) return true;
+            }
+        }
+        return false;
+    }
+
+    int row_count(int r) const {
+        const uint64_t* p = row(r);
+        int total = 0;
+        for (std::size_t k = 0; k < stride_; ++k) total += __builtin_popcountll(p[k]);
+        return total;
+    }
+
+    std::size_t count() const {
+        std::size_t total = 0;
+        for (int r = 0; r < rows_; ++r) total += row_count(r);
+        return total;
+    }
+
+    // Toggle every bit in rows r1..r2, columns c1..c2 (inclusive) with one
+    // XOR per touched word.
+    void flip_rect(int r1, int c1, int r2, int c2) {
+        const std::size_t w1 = c1 / WORD_BITS;
+        const std::size_t w2 = c2 / WORD_BITS;
+        const uint64_t head = ~uint64_t(0) << (c1 % WORD_BITS);
+        const uint64_t tail = ~uint64_t(0) >> (WORD_BITS - 1 - c2 % WORD_BITS);
+        for (int r = r1; r <= r2; ++r) {
+            uint64_t* p = row(r);
+            if (w1 == w2) {
+                p[w1] ^= head & tail;
+                continue;
+            }
+            p[w1] ^= head;
+            for (std::size_t k = w1 + 1; k < w2; ++k) p[k] = ~p[k];
+            p[w2] ^= tail;
+        }
+    }
+
+private:
+    uint64_t* data() { return external_ ? external_ : words_.data(); }
+    const uint64_t* data() const { return external_ ? external_ : words_.data(); }
+
+    uint64_t tail_mask() const {
+        return cols_ % WORD_BITS ? (uint64_t(1) << (cols_ % WORD_BITS)) - 1 : ~uint64_t(0);
+    }
+
+    int rows_ = 0;
+    int cols_ = 0;
+    std::size_t stride_ = 0;
+    uint64_t* external_ = nullptr;
+    std::vector<uint64_t, AlignedAllocator<uint64_t, 64>> words_;
+};
+
+}
+
+#endif
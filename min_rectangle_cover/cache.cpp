@@ -0,0 +1,216 @@
+#include "solution.h"
+#include "greedy.h"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace solution {
+    namespace {
+        // Packed image of one orientation: rows, cols, then the words.
+        struct Key {
+            int rows = 0;
+            int cols = 0;
+            vector<uint64_t> words;
+            uint64_t hash = 0;
+
+            bool operator==(const Key& other) const {
+                return rows == other.rows && cols == other.cols && words == other.words;
+            }
+        };
+
+        // The index holds pointers to the keys stored in the entries, so
+        // each key's words are kept once.
+        struct KeyHash {
+            size_t operator()(const Key* key) const { return static_cast<size_t>(key->hash); }
+        };
+
+        struct KeyEqual {
+            bool operator()(const Key* a, const Key* b) const { return *a == *b; }
+        };
+
+        // Symmetry t: bit 0 mirrors rows, bit 1 mirrors columns, bit 2
+        // then transposes. Cell (i, j) of the image is read from
+        // source_cell(t, ...) of the m x n input.
+        void source_cell(int t, int m, int n, int& i, int& j) {
+            if (t & 4) swap(i, j);
+            if (t & 1) i = m - 1 - i;
+            if (t & 2) j = n - 1 - j;
+        }
+
+        // Word k of row r of the image of symmetry t, read from bits
+        // without building the image.
+        uint64_t image_word(const BitMatrix& bits, int t, int r, int k) {
+            int m = bits.rows();
+            int n = bits.cols();
+            if (!(t & 6)) return bits.row((t & 1) ? m - 1 - r : r)[k];
+            int cols = (t & 4) ? m : n;
+            int first = k * BitMatrix::WORD_BITS;
+            int last = min(cols, first + BitMatrix::WORD_BITS);
+            uint64_t word = 0;
+            for (int c = first; c < last; ++c) {
+                int i = r, j = c;
+                source_cell(t, m, n, i, j);
+                word |= uint64_t(bits.get(i, j)) << (c - first);
+            }
+            return word;
+        }
+
+        // Whether the image of symmetry t orders before that of u: shape
+        // first, then the packed words. Words are produced only up to the
+        // first difference.
+        bool image_less(const BitMatrix& bits, int t, int u) {
+            int m = bits.rows();
+            int n = bits.cols();
+            int rows_t = (t & 4) ? n : m, rows_u = (u & 4) ? n : m;
+            if (rows_t != rows_u) return rows_t < rows_u;
+            int cols = (t & 4) ? m : n;
+            int words = (cols + BitMatrix::WORD_BITS - 1) / BitMatrix::WORD_BITS;
+            for (int r = 0; r < rows_t; ++r) {
+                for (int k = 0; k < words; ++k) {
+                    uint64_t a = image_word(bits, t, r, k);
+                    uint64_t b = image_word(bits, u, r, k);
+                    if (a != b) return a < b;
+                }
+            }
+            return false;
+        }
+
+        // Packed image of symmetry t, hashed.
+        Key image(const BitMatrix& bits, int t) {
+            Key key{(t & 4) ? bits.cols() : bits.rows(), (t & 4) ? bits.rows() : bits.cols(), {}, 0};
+            int words = (key.cols + BitMatrix::WORD_BITS - 1) / BitMatrix::WORD_BITS;
+            key.words.reserve(static_cast<size_t>(key.rows) * words);
+            for (int r = 0; r < key.rows; ++r) {
+                for (int k = 0; k < words; ++k) key.words.push_back(image_word(bits, t, r, k));
+            }
+            // FNV-1a over the words, seeded with the shape.
+            uint64_t h = 1469598103934665603ull ^ (uint64_t(key.rows) << 32 | uint32_t(key.cols));
+            for (uint64_t w : key.words) {
+                h ^= w;
+                h *= 1099511628211ull;
+            }
+            key.hash = h;
+            return key;
+        }
+
+        // Map a rectangle of the image of symmetry t back onto the m x n input.
+        Rect untransform(int t, int m, int n, const Rect& rect) {
+            int a1 = rect.r1, b1 = rect.c1, a2 = rect.r2, b2 = rect.c2;
+            if (t & 4) {
+                swap(a1, b1);
+                swap(a2, b2);
+            }
+            if (t & 2) {
+                b1 = n - 1 - b1;
+                b2 = n - 1 - b2;
+            }
+            if (t & 1) {
+                a1 = m - 1 - a1;
+                a2 = m - 1 - a2;
+            }
+            return {min(a1, a2), min(b1, b2), max(a1, a2), max(b1, b2)};
+        }
+
+        struct Entry {
+            Key key;
+            vector<Rect> rects;     // plan of the canonical image
+        };
+    }
+
+    struct SolveCache::State {
+        size_t capacity;
+        SolveOptions options;
+        mutable mutex lock;
+        // Most recently used first.
+        list<Entry> entries;
+        unordered_map<const Key*, list<Entry>::iterator, KeyHash, KeyEqual> index;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    SolveCache::SolveCache(size_t capacity, const SolveOptions& options)
+        : state_(new State{capacity, options, {}, {}, {}, 0, 0}) {
+        // Misses solve concurrently outside the lock; they must not share
+        // the caller's stats.
+        state_->options.stats = nullptr;
+    }
+
+    SolveCache::~SolveCache() = default;
+
+    Plan SolveCache::solve(int m, int n, const vector<vector<bool>>& matrix) {
+        State& s = *state_;
+        Scratch scratch;
+        load_matrix(m, n, matrix, scratch.bits);
+
+        int best = 0;
+        for (int t = 1; t < 8; ++t) {
+            if (image_less(scratch.bits, t, best)) best = t;
+        }
+        Key canonical = image(scratch.bits, best);
+
+        vector<Rect> rects;
+        bool found = false;
+        {
+            lock_guard<mutex> guard(s.lock);
+            auto it = s.index.find(&canonical);
+            if (it != s.index.end()) {
+                s.entries.splice(s.entries.begin(), s.entries, it->second);
+                rects = it->second->rects;
+                found = true;
+                ++s.hits;
+            } else {
+                ++s.misses;
+            }
+        }
+
+        if (!found) {
+            // Solve outside the lock; a concurrent miss on the same key
+            // computes the same plan and the second insert is dropped.
+            size_t words = canonical.rows ? canonical.words.size() / canonical.rows : 0;
+            scratch.bits.load(canonical.words.data(), canonical.rows, canonical.cols, words);
+            solve_packed(scratch, s.options, scan_pool(s.options, canonical.rows), &rects);
+
+            lock_guard<mutex> guard(s.lock);
+            if (s.capacity > 0 && !s.index.count(&canonical)) {
+                s.entries.push_front(Entry{std::move(canonical), rects});
+                s.index.emplace(&s.entries.front().key, s.entries.begin());
+                if (s.entries.size() > s.capacity) {
+                    s.index.erase(&s.entries.back().key);
+                    s.entries.pop_back();
+                }
+            }
+        }
+
+        Plan plan;
+        plan.rects.reserve(rects.size());
+        for (const Rect& rect : rects) plan.rects.push_back(untransform(best, m, n, rect));
+        plan.flips = static_cast<int>(plan.rects.size());
+        return plan;
+    }
+
+    uint64_t SolveCache::hits() const {
+        lock_guard<mutex> guard(state_->lock);
+        return state_->hits;
+    }
+
+    uint64_t SolveCache::misses() const {
+        lock_guard<mutex> guard(state_->lock);
+        return state_->misses;
+    }
+
+    size_t SolveCache::size() const {
+        lock_guard<mutex> guard(state_->lock);
+        return state_->entries.size();
+    }
+
+    void SolveCache::clear() {
+        lock_guard<mutex> guard(state_->lock);
+        state_->index.clear();
+        state_->entries.clear();
+    }
+}
@@ -0,0 +1,141 @@
+// Command-line driver for the rectangle cover solver.
+//
+//   g++ -O2 -std=c++17 -pthread cli.cpp solution.cpp row_max.cpp matrix_file.cpp -o rect_cover
+//
+//   rect_cover [--threads N] [--strategy exhaustive|lazy|maximal|corner]
+//              [--scoring cover|net] [--dedup] FILE
+//       Solve every matrix of a packed matrix file (see matrix_file.h) and
+//       print "<index> <flips>" per matrix, in file order. A matrix that
+//       fails to solve prints "<index> error" and its reason on stderr, and
+//       the exit status is then 1.
+//   rect_cover --pack TEXT BIN
+//       Convert a text file of "m n" headers, each followed by m rows of
+//       0/1 characters, into a packed matrix file.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "greedy.h"
+#include "matrix_file.h"
+#include "solution.h"
+
+using namespace solution;
+
+static int usage() {
+    std::fprintf(stderr,
+                 "usage: rect_cover [--threads N] [--strategy exhaustive|lazy|maximal|corner]\n"
+                 "                  [--scoring cover|net] [--dedup] FILE\n"
+                 "       rect_cover --pack TEXT BIN\n");
+    return 2;
+}
+
+static void pack(const string& text_path, const string& bin_path) {
+    ifstream in(text_path);
+    if (!in) throw std::runtime_error("cannot open " + text_path);
+    vector<vector<vector<bool>>> matrices;
+    int m, n;
+    while (in >> m >> n) {
+        if (m < 0 || n < 0) throw std::runtime_error(text_path + ": negative dimensions");
+        vector<vector<bool>> matrix(m, vector<bool>(n));
+        for (int i = 0; i < m; ++i) {
+            for (int j = 0; j < n; ++j) {
+                char ch;
+                if (!(in >> ch) || (ch != '0' && ch != '1')) {
+                    throw std::runtime_error(text_path + ": expected 0 or 1");
+                }
+                matrix[i][j] = ch == '1';
+            }
+        }
+        matrices.push_back(std::move(matrix));
+    }
+    write_matrix_file(bin_path, matrices);
+}
+
+// Returns false when any matrix failed.
+static bool run(const string& path, const SolveOptions& options) {
+    MatrixFile file(path);
+    ThreadPool pool(options.threads);
+    vector<Scratch> scratch(pool.size());
+
+    // Solve in chunks so results stream out in file order while the pool
+    // stays busy.
+    const size_t chunk = 256 * static_cast<size_t>(pool.size());
+    vector<int> flips;
+    vector<string> errors;
+    bool ok = true;
+    for (size_t begin = 0; begin < file.size(); begin += chunk) {
+        size_t count = std::min(chunk, file.size() - begin);
+        flips.assign(count, 0);
+        errors.assign(count, string());
+        pool.parallel_for(static_cast<int>(count), [&](int job, int worker) {
+            // An exception must not escape a pool job.
+            try {
+                PackedMatrixView view = file.view(begin + job);
+                Scratch& s = scratch[worker];
+                s.bits.load(view.words, view.rows, view.cols, view.stride);
+                flips[job] = solve_packed(s, options, nullptr);
+            } catch (const std::exception& e) {
+                errors[job] = e.what();
+                if (errors[job].empty()) errors[job] = "unknown error";
+            } catch (...) {
+                errors[job] = "unknown error";
+            }
+        });
+        for (size_t i = 0; i < count; ++i) {
+            if (errors[i].empty()) {
+                std::printf("%zu %d\n", begin + i, flips[i]);
+                continue;
+            }
+            std::printf("%zu error\n", begin + i);
+            std::fprintf(stderr, "rect_cover: matrix %zu: %s\n", begin + i, errors[i].c_str());
+            ok = false;
+        }
+        std::fflush(stdout);
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    SolveOptions options;
+    vector<string> args(argv + 1, argv + argc);
+    try {
+        if (args.size() == 3 && args[0] == "--pack") {
+            pack(args[1], args[2]);
+            return 0;
+        }
+        string path;
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (args[i] == "--threads" && i + 1 < args.size()) {
+                options.threads = std::atoi(args[++i].c_str());
+            } else if (args[i] == "--strategy" && i + 1 < args.size()) {
+                const string& name = args[++i];
+                if (name == "exhaustive") options.strategy = Strategy::EXHAUSTIVE;
+                else if (name == "lazy") options.strategy = Strategy::LAZY;
+                else if (name == "maximal") options.strategy = Strategy::MAXIMAL;
+                else if (name == "corner") options.strategy = Strategy::CORNER;
+                else return usage();
+            } else if (args[i] == "--scoring" && i + 1 < args.size()) {
+                const string& name = args[++i];
+                if (name == "cover") options.scoring = Scoring::COVER;
+                else if (name == "net") options.scoring = Scoring::NET_GAIN;
+                else return usage();
+            } else if (args[i] == "--dedup") {
+                options.dedup = true;
+            } else if (path.empty() && args[i].rfind("--", 0) != 0) {
+                path = args[i];
+            } else {
+                return usage();
+            }
+        }
+        if (path.empty()) return usage();
+        if (!run(path, options)) return 1;
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "rect_cover: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include "solution.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace solution {
+    // Iterative-deepening search over matrices of at most 64 cells packed
+    // into one word (bit r*n + c). Branching uses the corner view of a flip:
+    // a rectangle toggles exactly four cells of the 2D XOR-difference grid,
+    // the first set cell is always an odd corner, and some rectangle in any
+    // solution must have a corner there, so only those m*n rectangles are
+    // tried. ceil(odd corners / 4) is an admissible bound for pruning.
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        // New states stop being remembered past this many, and the search
+        // goes on without them; the table is only a cache, so correctness
+        // does not depend on it.
+        const size_t MAX_MEMO = size_t(1) << 22;
+
+        struct Move {
+            uint64_t mask;
+            Rect rect;
+        };
+
+        struct Search {
+            int m, n;
+            uint64_t row_mask;
+            vector<vector<Move>> moves_at;       // rectangles with a corner at cell p
+            vector<Rect> path;                   // moves of the current branch
+            unordered_map<uint64_t, int> failed; // state -> depth known to fail
+            uint64_t nodes = 0;
+            uint64_t node_budget;
+            bool has_deadline;
+            Clock::time_point deadline;
+            bool out_of_budget = false;
+
+            uint64_t rect_mask(int r1, int c1, int r2, int c2) const {
+                uint64_t cols = (c2 - c1 + 1 == 64) ? ~uint64_t(0)
+                              : ((uint64_t(1) << (c2 - c1 + 1)) - 1) << c1;
+                uint64_t mask = 0;
+                for (int r = r1; r <= r2; ++r) mask |= cols << (r * n);
+                return mask;
+            }
+
+            int odd_corners(uint64_t state) const {
+                int odd = 0;
+                uint64_t prev = 0;
+                for (int i = 0; i <= m; ++i) {
+                    uint64_t cur = i < m ? (state >> (i * n)) & row_mask : 0;
+                    uint64_t v = cur ^ prev;
+                    odd += __builtin_popcountll((v ^ (v << 1)) & row_mask);
+                    odd += (v >> (n - 1)) & 1;
+                    prev = cur;
+                }
+                return odd;
+            }
+
+            int lower_bound(uint64_t state) const {
+                return (odd_corners(state) + 3) / 4;
+            }
+
+            bool exhausted() {
+                if (out_of_budget) return true;
+                if (node_budget && nodes >= node_budget) out_of_budget = true;
+                if (has_deadline && (nodes & 15) == 0 && Clock::now() >= deadline) {
+                    out_of_budget = true;
+                }
+                return out_of_budget;
+            }
+
+            // True when state can be cleared with at most `depth` flips.
+            bool dfs(uint64_t state, int depth) {
+                if (state == 0) return true;
+                if (lower_bound(state) > depth) return false;
+                ++nodes;
+                if (exhausted()) return false;
+
+                auto it = failed.find(state);
+                bool remembered = it != failed.end();
+                if (remembered && it->second >= depth) return false;
+
+                const vector<Move>& moves = moves_at[__builtin_ctzll(state)];
+                vector<pair<int, const Move*>> children;
+                children.reserve(moves.size());
+                for (const Move& move : moves) {
+                    int lb = lower_bound(state ^ move.mask);
+                    if (lb <= depth - 1) children.push_back({lb, &move});
+                }
+                stable_sort(children.begin(), children.end(),
+                            [](const pair<int, const Move*>& a, const pair<int, const Move*>& b) {
+                                return a.first < b.first;
+                            });
+                for (const auto& child : children) {
+                    path.push_back(child.second->rect);
+                    if (dfs(state ^ child.second->mask, depth - 1)) return true;
+                    path.pop_back();
+                    if (out_of_budget) return false;
+                }
+
+                if (remembered || failed.size() < MAX_MEMO) {
+                    int& known = failed[state];
+                    known = max(known, depth);
+                }
+                return false;
+            }
+        };
+    }
+
+    ExactResult solve_exact(int m, int n, const vector<vector<bool>>& matrix,
+                            const ExactOptions& options){
+        if (m < 0 || n < 0) {
+            throw std::invalid_argument("m < 0 or n < 0");
+        }
+        if (static_cast<long long>(m) * n > 64) {
+            throw std::invalid_argument("solve_exact needs m * n <= 64");
+        }
+        // The time budget covers the setup below as well as the search.
+        Clock::time_point deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::milli>(options.time_budget_ms));
+        ExactResult result;
+        Plan seed = solve_with_plan(m, n, matrix);
+        int greedy = seed.flips;
+        result.flips = greedy;
+        result.rects = std::move(seed.rects);
+        if (greedy == 0) {
+            result.optimal = true;
+            return result;
+        }
+
+        Search search;
+        search.m = m;
+        search.n = n;
+        search.row_mask = n == 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+        search.node_budget = options.node_budget;
+        search.has_deadline = options.time_budget_ms > 0;
+        search.deadline = deadline;
+
+        uint64_t state = 0;
+        for (int i = 0; i < m; ++i) {
+            for (int j = 0; j < n; ++j) {
+                if (matrix[i][j]) state |= uint64_t(1) << (i * n + j);
+            }
+        }
+
+        search.moves_at.resize(static_cast<size_t>(m) * n);
+        for (int r1 = 0; r1 < m; ++r1) {
+            for (int c1 = 0; c1 < n; ++c1) {
+                for (int r2 = r1; r2 < m; ++r2) {
+                    for (int c2 = c1; c2 < n; ++c2) {
+                        Move move{search.rect_mask(r1, c1, r2, c2), Rect{r1, c1, r2, c2}};
+                        // Corners of the flip in the (m+1)x(n+1) difference
+                        // grid; only those inside the matrix can be a first
+                        // set cell.
+                        for (int r : {r1, r2 + 1}) {
+                            for (int c : {c1, c2 + 1}) {
+                                if (r < m && c < n) {
+                                    search.moves_at[r * n + c].push_back(move);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        result.lower_bound = search.lower_bound(state);
+        if (search.has_deadline && Clock::now() >= deadline) search.out_of_budget = true;
+        for (int depth = result.lower_bound; depth < greedy; ++depth) {
+            if (search.dfs(state, depth)) {
+                result.flips = depth;
+                result.rects = search.path;
+                result.lower_bound = depth;
+                result.optimal = true;
+                break;
+            }
+            if (search.out_of_budget) break;
+            result.lower_bound = depth + 1;
+        }
+        if (!search.out_of_budget && result.lower_bound >= greedy) {
+            result.optimal = true;
+            result.lower_bound = greedy;
+        }
+        result.nodes = search.nodes;
+        return result;
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef GREEDY_H
+#define GREEDY_H
+#include <memory>
+#include <vector>
+#include "bit_matrix.h"
+#include "solution.h"
+#include "thread_pool.h"
+using namespace std;
+
+// Internal interface of the greedy engine, shared by the translation units
+// of this directory. Not part of the public API in solution.h.
+namespace solution {
+struct Candidate{
+    int cover = -1;
+    Rect rect{-1, -1, -1, -1};
+};
+
+// Heap entry of the LAZY strategy: `key` bounds the best cover of any
+// rectangle anchored at `anchor` (r1 * n + c1). Entries whose version no
+// longer matches their anchor's are stale and dropped when popped.
+struct LazyEntry{
+    int key;
+    int anchor;
+    uint32_t version;
+};
+
+// Working memory of one greedy run. Every buffer is resized with assign(),
+// so a Scratch reused across calls only allocates when a matrix is larger
+// than any it has seen before.
+struct Scratch{
+    BitMatrix bits;
+    vector<int> pref;
+    vector<int> acc;
+    vector<int> heights;
+    vector<int> stack;
+    vector<Candidate> per_row;
+    vector<LazyEntry> heap;
+    vector<Candidate> anchor_best;
+    vector<uint32_t> anchor_version;
+    vector<char> anchor_fresh;
+    BitMatrix corners;
+    // Dedup: the merged matrix, and where each of its rows and columns
+    // starts in the original (one extra entry holds the end).
+    BitMatrix reduced;
+    vector<int> row_start;
+    vector<int> col_start;
+    vector<uint64_t> col_changes;
+    // Coarse-to-fine: the downsampled run, its lifted rectangles and the
+    // per-block counts of the row being downsampled.
+    unique_ptr<Scratch> coarse;
+    vector<Rect> lifted;
+    vector<int> block_ones;
+};
+
+// Largest mul * (bottom[k] - top[k]) - slope * k over k in [begin, end).
+// index is the first k reaching it, or -1 when value <= floor (the search
+// for it is skipped then).
+struct RowMax{
+    int value;
+    int index;
+};
+
+using RowMaxKernel = RowMax (*)(const int* bottom, const int* top, int begin, int end,
+                                int mul, int slope, int floor);
+
+enum class RowMaxIsa{ BEST, SCALAR, SSE41, AVX2 };
+
+// Kernel for isa, or null when this CPU lacks it. BEST is the widest one
+// the CPU supports, chosen on first use.
+RowMaxKernel row_max_kernel(RowMaxIsa isa = RowMaxIsa::BEST);
+
+// Throws std::invalid_argument unless rows x cols is a valid view with
+// rows at least min_stride units apart.
+void check_view(int rows, int cols, size_t stride, size_t min_stride, const void* data);
+
+// Validate dimensions and pack matrix into bits. Throws
+// std::invalid_argument on a size mismatch.
+void load_matrix(int m, int n, const vector<vector<bool>>& matrix, BitMatrix& bits);
+
+// Corner (2D XOR-difference) grid of bits, (rows+1) x (cols+1): flipping
+// (r1, c1, r2, c2) toggles its cells (r1, c1), (r1, c2+1), (r2+1, c1) and
+// (r2+1, c2+1), and it is clear exactly when bits is.
+void build_corners(const BitMatrix& bits, BitMatrix& corners);
+
+// Fewest rows an EXHAUSTIVE scan splits over a pool. Below this, waking
+// the workers every iteration costs more than scoring the rows does.
+constexpr int PARALLEL_MIN_ROWS = 16;
+
+// Scan pool for one EXHAUSTIVE solve of an m-row matrix, or null when the
+// scan would be serial: one thread, another strategy, or too few rows (which
+// includes every matrix the specialized small solver takes). The pool is
+// owned by the calling thread and kept for its later calls.
+ThreadPool* scan_pool(const SolveOptions& options, int m);
+
+// Clear options.stats, when collected, for a call that returns before
+// reaching solve_packed().
+void reset_stats(const SolveOptions& options);
+
+// Run the greedy on scratch.bits, which is cleared in the process, and
+// return the number of flips. pool may be null for a serial scan. When plan
+// is given, the flipped rectangles are appended to it in order.
+int solve_packed(Scratch& scratch, const SolveOptions& options, ThreadPool* pool,
+                 vector<Rect>* plan = nullptr);
+}
+#endif
@@ -0,0 +1,143 @@
+#include "solution.h"
+#include "greedy.h"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace solution {
+    struct IncrementalSolver::State {
+        int m, n;
+        IncrementalOptions options;
+        BitMatrix matrix;
+        BitMatrix corners;
+        size_t odd = 0;
+        Plan plan;
+        // Flips per unit of lower bound after the last rebuild.
+        double ratio = 1;
+        uint64_t rebuilds = 0;
+        Scratch scratch;
+        unique_ptr<ThreadPool> pool;
+
+        void solve_greedy() {
+            scratch.bits = matrix;
+            plan.rects.clear();
+            plan.flips = solve_packed(scratch, options.greedy, pool.get(), &plan.rects);
+            int bound = static_cast<int>((odd + 3) / 4);
+            ratio = bound ? static_cast<double>(plan.flips) / bound : 1;
+        }
+
+        void toggle_corner(int r, int c) {
+            bool was = corners.get(r, c);
+            corners.set(r, c, !was);
+            if (was) --odd;
+            else ++odd;
+        }
+
+        // Replace the plan's rectangles inside a window around (r, c), plus
+        // a 1x1 flip of the cell, by an exact cover of their XOR when that
+        // is shorter; otherwise append the 1x1 flip.
+        void repair(int r, int c) {
+            int side = options.window;
+            int h = min(side, m);
+            int w = min(side, n);
+            int r0 = max(0, min(r - side / 2, m - h));
+            int c0 = max(0, min(c - side / 2, n - w));
+
+            vector<size_t> group;
+            vector<vector<bool>> residual(h, vector<bool>(w, false));
+            residual[r - r0][c - c0] = true;
+            for (size_t k = 0; k < plan.rects.size(); ++k) {
+                const Rect& rect = plan.rects[k];
+                if (rect.r1 < r0 || rect.c1 < c0 || rect.r2 >= r0 + h || rect.c2 >= c0 + w) {
+                    continue;
+                }
+                group.push_back(k);
+                for (int i = rect.r1; i <= rect.r2; ++i) {
+                    for (int j = rect.c1; j <= rect.c2; ++j) {
+                        residual[i - r0][j - c0] = !residual[i - r0][j - c0];
+                    }
+                }
+            }
+
+            ExactOptions budget;
+            budget.node_budget = options.window_nodes;
+            ExactResult best = solve_exact(h, w, residual, budget);
+            if (best.flips >= static_cast<int>(group.size()) + 1) {
+                plan.rects.push_back({r, c, r, c});
+            } else {
+                for (auto it = group.rbegin(); it != group.rend(); ++it) {
+                    plan.rects.erase(plan.rects.begin() + *it);
+                }
+                for (const Rect& rect : best.rects) {
+                    plan.rects.push_back({rect.r1 + r0, rect.c1 + c0, rect.r2 + r0, rect.c2 + c0});
+                }
+            }
+            plan.flips = static_cast<int>(plan.rects.size());
+        }
+    };
+
+    IncrementalSolver::IncrementalSolver(int m, int n, const vector<vector<bool>>& matrix,
+                                         const IncrementalOptions& options)
+        : state_(new State{m, n, options, {}, {}, 0, {}, 1, 0, {}, nullptr}) {
+        if (options.window < 1 || options.window > 8) {
+            throw std::invalid_argument("window must be in 1..8");
+        }
+        State& s = *state_;
+        load_matrix(m, n, matrix, s.matrix);
+        build_corners(s.matrix, s.corners);
+        s.odd = s.corners.count();
+        if (options.greedy.threads != 1 && options.greedy.strategy == Strategy::EXHAUSTIVE) {
+            s.pool.reset(new ThreadPool(options.greedy.threads));
+        }
+        s.solve_greedy();
+    }
+
+    IncrementalSolver::~IncrementalSolver() = default;
+    IncrementalSolver::IncrementalSolver(IncrementalSolver&&) noexcept = default;
+    IncrementalSolver& IncrementalSolver::operator=(IncrementalSolver&&) noexcept = default;
+
+    void IncrementalSolver::toggle(int r, int c) {
+        State& s = *state_;
+        if (r < 0 || r >= s.m || c < 0 || c >= s.n) {
+            throw std::out_of_range("toggle outside the matrix");
+        }
+        s.matrix.set(r, c, !s.matrix.get(r, c));
+        for (int i = r; i <= r + 1; ++i) {
+            for (int j = c; j <= c + 1; ++j) s.toggle_corner(i, j);
+        }
+        s.repair(r, c);
+
+        double expected = s.ratio * lower_bound();
+        if (s.options.max_drift > 0 && s.plan.flips > s.options.max_drift * expected + 1) {
+            rebuild();
+        }
+    }
+
+    void IncrementalSolver::rebuild() {
+        state_->solve_greedy();
+        ++state_->rebuilds;
+    }
+
+    bool IncrementalSolver::get(int r, int c) const {
+        const State& s = *state_;
+        if (r < 0 || r >= s.m || c < 0 || c >= s.n) {
+            throw std::out_of_range("get outside the matrix");
+        }
+        return s.matrix.get(r, c);
+    }
+
+    const Plan& IncrementalSolver::plan() const {
+        return state_->plan;
+    }
+
+    int IncrementalSolver::lower_bound() const {
+        return static_cast<int>((state_->odd + 3) / 4);
+    }
+
+    uint64_t IncrementalSolver::rebuilds() const {
+        return state_->rebuilds;
+    }
+}
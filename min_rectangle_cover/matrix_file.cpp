@@ -0,0 +1,122 @@
+#include "matrix_file.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace solution {
+    static const char MAGIC[4] = {'R', 'C', 'O', 'V'};
+    static const uint32_t VERSION = 1;
+    static const size_t HEADER_BYTES = 16;
+    static const size_t RECORD_HEADER_BYTES = 8;
+
+    static uint32_t read_u32(const unsigned char* p){
+        uint32_t v;
+        memcpy(&v, p, sizeof v);
+        return v;
+    }
+
+    static uint64_t read_u64(const unsigned char* p){
+        uint64_t v;
+        memcpy(&v, p, sizeof v);
+        return v;
+    }
+
+    MatrixFile::MatrixFile(const string& path){
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("cannot open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot stat " + path);
+        }
+        length_ = static_cast<size_t>(st.st_size);
+        if (length_ < HEADER_BYTES) {
+            ::close(fd);
+            throw std::runtime_error(path + ": truncated header");
+        }
+        void* mapped = ::mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) throw std::runtime_error("cannot map " + path);
+        data_ = static_cast<const unsigned char*>(mapped);
+        ::madvise(mapped, length_, MADV_SEQUENTIAL);
+
+        try {
+            if (memcmp(data_, MAGIC, sizeof MAGIC) != 0 || read_u32(data_ + 4) != VERSION) {
+                throw std::runtime_error(path + ": not a version 1 matrix file");
+            }
+            uint64_t count = read_u64(data_ + 8);
+            size_t offset = HEADER_BYTES;
+            for (uint64_t i = 0; i < count; ++i) {
+                if (length_ - offset < RECORD_HEADER_BYTES) {
+                    throw std::runtime_error(path + ": truncated record header");
+                }
+                uint64_t rows = read_u32(data_ + offset);
+                uint64_t cols = read_u32(data_ + offset + 4);
+                uint64_t stride = (cols + 63) / 64;
+                if (rows > 0x7fffffff || cols > 0x7fffffff) {
+                    throw std::runtime_error(path + ": matrix too large");
+                }
+                uint64_t bytes = rows * stride * 8;
+                if ((length_ - offset - RECORD_HEADER_BYTES) < bytes) {
+                    throw std::runtime_error(path + ": truncated matrix data");
+                }
+                offsets_.push_back(offset);
+                offset += RECORD_HEADER_BYTES + bytes;
+            }
+        } catch (...) {
+            ::munmap(mapped, length_);
+            throw;
+        }
+    }
+
+    MatrixFile::~MatrixFile(){
+        if (data_) ::munmap(const_cast<unsigned char*>(data_), length_);
+    }
+
+    PackedMatrixView MatrixFile::view(size_t index) const{
+        if (index >= offsets_.size()) throw std::out_of_range("matrix index out of range");
+        const unsigned char* p = data_ + offsets_[index];
+        PackedMatrixView v;
+        v.rows = static_cast<int>(read_u32(p));
+        v.cols = static_cast<int>(read_u32(p + 4));
+        v.stride = (static_cast<size_t>(v.cols) + 63) / 64;
+        v.words = reinterpret_cast<const uint64_t*>(p + RECORD_HEADER_BYTES);
+        return v;
+    }
+
+    void write_matrix_file(const string& path, const vector<vector<vector<bool>>>& matrices){
+        ofstream out(path, ios::binary | ios::trunc);
+        if (!out) throw std::runtime_error("cannot create " + path);
+
+        uint64_t count = matrices.size();
+        out.write(MAGIC, sizeof MAGIC);
+        out.write(reinterpret_cast<const char*>(&VERSION), sizeof VERSION);
+        out.write(reinterpret_cast<const char*>(&count), sizeof count);
+
+        vector<uint64_t> row;
+        for (const auto& matrix : matrices) {
+            uint32_t rows = static_cast<uint32_t>(matrix.size());
+            uint32_t cols = rows ? static_cast<uint32_t>(matrix[0].size()) : 0;
+            out.write(reinterpret_cast<const char*>(&rows), sizeof rows);
+            out.write(reinterpret_cast<const char*>(&cols), sizeof cols);
+            for (const auto& bits : matrix) {
+                if (bits.size() != cols) {
+                    throw std::invalid_argument("row length != cols");
+                }
+                row.assign((cols + 63) / 64, 0);
+                for (uint32_t c = 0; c < cols; ++c) {
+                    if (bits[c]) row[c / 64] |= uint64_t(1) << (c % 64);
+                }
+                out.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(uint64_t));
+            }
+        }
+        if (!out) throw std::runtime_error("write failed: " + path);
+    }
+}
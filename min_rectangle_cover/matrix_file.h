@@ -0,0 +1,41 @@
+#ifndef MATRIX_FILE_H
+#define MATRIX_FILE_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "solution.h"
+using namespace std;
+
+// Bit-packed on-disk container for rectangle cover inputs.
+//
+// All integers are little-endian. The file starts with a 16-byte header:
+//   char[4] magic "RCOV", uint32 version (1), uint64 matrix count.
+// Each matrix follows as
+//   uint32 rows, uint32 cols, rows * ceil(cols / 64) uint64 words,
+// one row after another, bit c of a row in word c / 64 at position c % 64.
+// Bits past `cols` in the last word of a row must be zero. Every record
+// starts on an 8-byte boundary, so a mapped file can be read in place.
+namespace solution {
+// Read-only memory mapping of a matrix file. Records are indexed on open;
+// view() points straight into the mapping.
+class MatrixFile {
+public:
+    explicit MatrixFile(const string& path);
+    ~MatrixFile();
+    MatrixFile(const MatrixFile&) = delete;
+    MatrixFile& operator=(const MatrixFile&) = delete;
+
+    size_t size() const { return offsets_.size(); }
+    PackedMatrixView view(size_t index) const;
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t length_ = 0;
+    vector<size_t> offsets_;
+};
+
+// Write matrices (dimensions taken from the vectors) in the format above.
+void write_matrix_file(const string& path, const vector<vector<vector<bool>>>& matrices);
+}
+#endif
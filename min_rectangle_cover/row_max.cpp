@@ -0,0 +1,148 @@
+#include "greedy.h"
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ROW_MAX_X86 1
+#endif
+
+namespace solution {
+    // Every kernel returns the largest mul * (bottom[k] - top[k]) - slope * k
+    // over [begin, end) and, when it beats `floor`, the first k reaching
+    // it. The index is looked for only then, in a second pass that stops
+    // at the first match.
+    namespace {
+        int score_at(const int* bottom, const int* top, int k, int mul, int slope) {
+            return mul * (bottom[k] - top[k]) - slope * k;
+        }
+
+        RowMax row_max_scalar(const int* bottom, const int* top, int begin, int end,
+                              int mul, int slope, int floor) {
+            RowMax best{INT32_MIN, -1};
+            for (int k = begin; k < end; ++k) {
+                int score = score_at(bottom, top, k, mul, slope);
+                if (score > best.value) best = {score, k};
+            }
+            if (best.value <= floor) best.index = -1;
+            return best;
+        }
+
+#ifdef ROW_MAX_X86
+        __attribute__((target("avx2")))
+        RowMax row_max_avx2(const int* bottom, const int* top, int begin, int end,
+                            int mul, int slope, int floor) {
+            const __m256i vmul = _mm256_set1_epi32(mul);
+            const __m256i vslope = _mm256_set1_epi32(slope);
+            const __m256i step = _mm256_set1_epi32(8);
+            __m256i ramp = _mm256_add_epi32(_mm256_set1_epi32(begin),
+                                            _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+            __m256i vmax = _mm256_set1_epi32(INT32_MIN);
+            int k = begin;
+            for (; k + 8 <= end; k += 8) {
+                __m256i d = _mm256_sub_epi32(
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bottom + k)),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(top + k)));
+                __m256i score = _mm256_sub_epi32(_mm256_mullo_epi32(d, vmul),
+                                                 _mm256_mullo_epi32(ramp, vslope));
+                vmax = _mm256_max_epi32(vmax, score);
+                ramp = _mm256_add_epi32(ramp, step);
+            }
+            __m128i half = _mm_max_epi32(_mm256_castsi256_si128(vmax),
+                                         _mm256_extracti128_si256(vmax, 1));
+            half = _mm_max_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+            half = _mm_max_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+            int value = _mm_cvtsi128_si32(half);
+            for (; k < end; ++k) value = std::max(value, score_at(bottom, top, k, mul, slope));
+
+            if (value <= floor) return {value, -1};
+            const __m256i target = _mm256_set1_epi32(value);
+            ramp = _mm256_add_epi32(_mm256_set1_epi32(begin),
+                                    _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+            for (k = begin; k + 8 <= end; k += 8) {
+                __m256i d = _mm256_sub_epi32(
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bottom + k)),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(top + k)));
+                __m256i score = _mm256_sub_epi32(_mm256_mullo_epi32(d, vmul),
+                                                 _mm256_mullo_epi32(ramp, vslope));
+                int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(score, target)));
+                if (mask) return {value, k + __builtin_ctz(mask)};
+                ramp = _mm256_add_epi32(ramp, step);
+            }
+            for (; k < end; ++k) {
+                if (score_at(bottom, top, k, mul, slope) == value) return {value, k};
+            }
+            return {value, -1};
+        }
+
+        __attribute__((target("sse4.1")))
+        RowMax row_max_sse41(const int* bottom, const int* top, int begin, int end,
+                             int mul, int slope, int floor) {
+            const __m128i vmul = _mm_set1_epi32(mul);
+            const __m128i vslope = _mm_set1_epi32(slope);
+            const __m128i step = _mm_set1_epi32(4);
+            __m128i ramp = _mm_add_epi32(_mm_set1_epi32(begin), _mm_setr_epi32(0, 1, 2, 3));
+            __m128i vmax = _mm_set1_epi32(INT32_MIN);
+            int k = begin;
+            for (; k + 4 <= end; k += 4) {
+                __m128i d = _mm_sub_epi32(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + k)),
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + k)));
+                __m128i score = _mm_sub_epi32(_mm_mullo_epi32(d, vmul),
+                                              _mm_mullo_epi32(ramp, vslope));
+                vmax = _mm_max_epi32(vmax, score);
+                ramp = _mm_add_epi32(ramp, step);
+            }
+            vmax = _mm_max_epi32(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(1, 0, 3, 2)));
+            vmax = _mm_max_epi32(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(2, 3, 0, 1)));
+            int value = _mm_cvtsi128_si32(vmax);
+            for (; k < end; ++k) value = std::max(value, score_at(bottom, top, k, mul, slope));
+
+            if (value <= floor) return {value, -1};
+            const __m128i target = _mm_set1_epi32(value);
+            ramp = _mm_add_epi32(_mm_set1_epi32(begin), _mm_setr_epi32(0, 1, 2, 3));
+            for (k = begin; k + 4 <= end; k += 4) {
+                __m128i d = _mm_sub_epi32(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + k)),
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + k)));
+                __m128i score = _mm_sub_epi32(_mm_mullo_epi32(d, vmul),
+                                              _mm_mullo_epi32(ramp, vslope));
+                int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(score, target)));
+                if (mask) return {value, k + __builtin_ctz(mask)};
+                ramp = _mm_add_epi32(ramp, step);
+            }
+            for (; k < end; ++k) {
+                if (score_at(bottom, top, k, mul, slope) == value) return {value, k};
+            }
+            return {value, -1};
+        }
+#endif
+
+        RowMaxKernel pick_kernel() {
+#ifdef ROW_MAX_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) return row_max_avx2;
+            if (__builtin_cpu_supports("sse4.1")) return row_max_sse41;
+#endif
+            return row_max_scalar;
+        }
+    }
+
+    RowMaxKernel row_max_kernel(RowMaxIsa isa) {
+        static const RowMaxKernel best = pick_kernel();
+        switch (isa) {
+        case RowMaxIsa::BEST:
+            return best;
+        case RowMaxIsa::SCALAR:
+            return row_max_scalar;
+#ifdef ROW_MAX_X86
+        case RowMaxIsa::SSE41:
+            return __builtin_cpu_supports("sse4.1") ? row_max_sse41 : nullptr;
+        case RowMaxIsa::AVX2:
+            return __builtin_cpu_supports("avx2") ? row_max_avx2 : nullptr;
+#endif
+        default:
+            return nullptr;
+        }
+    }
+}
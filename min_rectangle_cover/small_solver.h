@@ -0,0 +1,90 @@
+#ifndef SMALL_SOLVER_H
+#define SMALL_SOLVER_H
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "solution.h"
+using namespace std;
+
+// Greedy solver specialized for matrices of at most 8x8 cells packed into
+// one word, bit r * N + c. Every rectangle is a precomputed mask, so scoring
+// is popcount(mask & state) and flipping is one XOR. Rectangles are listed
+// in (r1, c1, r2, c2) order and the first strictly larger score wins, so the
+// result is exactly that of the EXHAUSTIVE strategy under either Scoring.
+namespace solution {
+template <int M, int N>
+struct SmallTables {
+    static_assert(M >= 1 && N >= 1 && M * N <= 64, "matrix must fit in 64 bits");
+    static constexpr int COUNT = (M * (M + 1) / 2) * (N * (N + 1) / 2);
+
+    array<uint64_t, COUNT> mask{};
+    array<Rect, COUNT> rect{};
+    array<int, COUNT> area{};
+    // Rectangles anchored at cell a are [first[a], first[a + 1]).
+    array<int, M * N + 1> first{};
+};
+
+template <int M, int N>
+constexpr SmallTables<M, N> make_small_tables() {
+    SmallTables<M, N> t;
+    int i = 0;
+    for (int r1 = 0; r1 < M; ++r1) {
+        for (int c1 = 0; c1 < N; ++c1) {
+            t.first[r1 * N + c1] = i;
+            for (int r2 = r1; r2 < M; ++r2) {
+                for (int c2 = c1; c2 < N; ++c2) {
+                    uint64_t cols = ((uint64_t(1) << (c2 - c1 + 1)) - 1) << c1;
+                    uint64_t mask = 0;
+                    for (int r = r1; r <= r2; ++r) mask |= cols << (r * N);
+                    t.mask[i] = mask;
+                    t.rect[i] = Rect{r1, c1, r2, c2};
+                    t.area[i] = (r2 - r1 + 1) * (c2 - c1 + 1);
+                    ++i;
+                }
+            }
+        }
+    }
+    t.first[M * N] = i;
+    return t;
+}
+
+template <int M, int N>
+inline constexpr SmallTables<M, N> SMALL_TABLES = make_small_tables<M, N>();
+
+// Greedy flip count for an M x N matrix packed as bit r * N + c. When plan
+// is given, the flipped rectangles are appended to it in order.
+template <int M, int N>
+int solve(uint64_t state, vector<Rect>* plan = nullptr, Scoring scoring = Scoring::COVER) {
+    const SmallTables<M, N>& t = SMALL_TABLES<M, N>;
+    const bool net = scoring == Scoring::NET_GAIN;
+    int flips = 0;
+    while (state) {
+        int best_cover = -1;
+        int best = -1;
+        for (int a = 0; a < M * N; ++a) {
+            if (!((state >> a) & 1)) continue;
+            // The anchor's last rectangle spans its whole quadrant and
+            // bounds every other cover, and so every net gain, it owns.
+            int last = t.first[a + 1] - 1;
+            if (__builtin_popcountll(t.mask[last] & state) <= best_cover) continue;
+            for (int i = t.first[a]; i < t.first[a + 1]; ++i) {
+                int cover = __builtin_popcountll(t.mask[i] & state);
+                if (net) cover = 2 * cover - t.area[i];
+                if (cover > best_cover) {
+                    best_cover = cover;
+                    best = i;
+                }
+            }
+        }
+        state ^= t.mask[best];
+        if (plan) plan->push_back(t.rect[best]);
+        ++flips;
+    }
+    return flips;
+}
+
+// Run solve<m, n> for 1 <= m, n <= 8, chosen at run time.
+int solve_small(int m, int n, uint64_t state, vector<Rect>* plan = nullptr,
+                Scoring scoring = Scoring::COVER);
+}
+#endif
@@ -1,52 +1,473 @@
 #include "solution.h"
+#include "greedy.h"
+#include "small_solver.h"
+#include <memory>
+#include <utility>
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <stdexcept>
 
 using namespace std;
 
+// STATS(...) runs its statements only when stats collection is compiled in;
+// STATS_CLOCK(name) declares a timer in the enclosing scope.
+#ifdef RECT_COVER_STATS
+#define STATS(...) do { if (stats) { __VA_ARGS__; } } while (0)
+#define STATS_CLOCK(name) auto name = chrono::steady_clock::now()
+#else
+#define STATS(...) do {} while (0)
+#define STATS_CLOCK(name) do {} while (0)
+#endif
+
 namespace solution {
-    struct Rect{
-        int r1, c1, r2, c2;
-    };
+#ifdef RECT_COVER_STATS
+    static uint64_t elapsed_ns(chrono::steady_clock::time_point since){
+        return chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now() - since).count();
+    }
 
-    bool matrix_has_ones(const vector<vector<bool>>& matrix){
-        for (const auto& row : matrix){
-            for (bool val : row){
-                if (val) return true;
+    // Rectangles the EXHAUSTIVE scan scores and skips in one iteration:
+    // anchor (r1, c1) owns (m - r1) * (n - c1) of them.
+    static void count_candidates(const BitMatrix& bits, SolveStats* stats){
+        int m = bits.rows();
+        int n = bits.cols();
+        for (int r1 = 0; r1 < m; ++r1){
+            for (int c1 = 0; c1 < n; ++c1){
+                uint64_t owned = static_cast<uint64_t>(m - r1) * (n - c1);
+                if (bits.get(r1, c1)) stats->candidates_scanned += owned;
+                else stats->candidates_skipped += owned;
             }
         }
-        return false;
+    }
+#endif
+
+    bool matrix_has_ones(const BitMatrix& matrix){
+        return matrix.any();
     }
 
-    static void build_pref(const vector<vector<bool>>& matrix,
-                           vector<vector<int>>& pref){
-        int m = matrix.size();
-        int n = matrix[0].size();
+    // pref is a flat (m+1)x(n+1) table; row i starts at i*(n+1).
+    static void build_pref(const BitMatrix& matrix, vector<int>& pref){
+        int m = matrix.rows();
+        int n = matrix.cols();
+        size_t width = static_cast<size_t>(n) + 1;
 
         for (int i = 0; i < m; ++i) {
+            const uint64_t* words = matrix.row(i);
+            const int* above = &pref[static_cast<size_t>(i) * width];
+            int* out = &pref[static_cast<size_t>(i + 1) * width];
             int row = 0;
-            for (int j = 0; j < n; ++j) {
-                row += matrix[i][j];
-                pref[i+1][j+1] = pref[i][j+1] + row;
+            for (int j = 0; j < n; j += BitMatrix::WORD_BITS) {
+                uint64_t w = words[j / BitMatrix::WORD_BITS];
+                int end = min(n, j + BitMatrix::WORD_BITS);
+                if (!w) {
+                    for (int k = j; k < end; ++k) out[k+1] = above[k+1] + row;
+                    continue;
+                }
+                for (int k = j; k < end; ++k, w >>= 1) {
+                    row += w & 1u;
+                    out[k+1] = above[k+1] + row;
+                }
+            }
+        }
+    }
+
+    // Patch pref after `rect` has been flipped in `matrix` instead of
+    // rebuilding it. Only entries below and right of the rectangle's top-left
+    // corner change: rows inside the rectangle take their own running delta,
+    // and every row past r2 takes the same per-column delta, which stays
+    // constant right of c2. `acc` is scratch of at least n+1 ints.
+    // A flip costs O((m - r1) * (n - c1)), still O(mn) for a rectangle near
+    // the top-left corner. Lazily applied block deltas would bound it by the
+    // rectangle instead, but the scans read raw pref rows (row_max() walks
+    // two of them with SIMD), so every read of the O(m^2 n^2) scan would pay
+    // for the delta lookup to save one O(mn) pass per flip.
+    static void update_pref(const BitMatrix& matrix, vector<int>& pref,
+                            vector<int>& acc, const Rect& rect){
+        int m = matrix.rows();
+        int n = matrix.cols();
+        size_t width = static_cast<size_t>(n) + 1;
+
+        fill(acc.begin() + rect.c1 + 1, acc.begin() + rect.c2 + 2, 0);
+        for (int r = rect.r1; r <= rect.r2; ++r) {
+            int row = 0;
+            for (int c = rect.c1; c <= rect.c2; ++c) {
+                row += matrix.get(r, c) ? 1 : -1;
+                acc[c+1] += row;
             }
+            int* out = &pref[static_cast<size_t>(r + 1) * width];
+            for (int j = rect.c1 + 1; j <= rect.c2 + 1; ++j) out[j] += acc[j];
+            int tail = acc[rect.c2 + 1];
+            for (int j = rect.c2 + 2; j <= n; ++j) out[j] += tail;
+        }
+        int tail = acc[rect.c2 + 1];
+        for (int i = rect.r2 + 2; i <= m; ++i) {
+            int* out = &pref[static_cast<size_t>(i) * width];
+            for (int j = rect.c1 + 1; j <= rect.c2 + 1; ++j) out[j] += acc[j];
+            for (int j = rect.c2 + 2; j <= n; ++j) out[j] += tail;
         }
     }
 
-    static int sum_rect(const vector<vector<int>>& pref,
+    static int sum_rect(const vector<int>& pref, size_t width,
                         int r1,int c1,int r2,int c2){
-        return pref[r2+1][c2+1] -
-               pref[r1][c2+1] -
-               pref[r2+1][c1] +
-               pref[r1][c1];
+        size_t top = static_cast<size_t>(r1) * width;
+        size_t bottom = static_cast<size_t>(r2 + 1) * width;
+        return pref[bottom + c2+1] -
+               pref[top + c2+1] -
+               pref[bottom + c1] +
+               pref[top + c1];
+    }
+
+    // Best rectangle anchored at (r1, c1), scanned in (r2, c2) order so the
+    // first strictly larger score wins. Does not look at the anchor cell.
+    // With `net`, a rectangle scores ones - zeros = 2 * ones - area.
+    //
+    // For one r2 the cover of every c2 is d[c2+1] - d[c1] with d the
+    // difference of pref rows r2+1 and r1, so each r2 is one row_max()
+    // call over d (vectorized where the CPU allows); net gain adds a
+    // linear term in c2.
+    static Candidate best_at_anchor(const vector<int>& pref, int m, int n,
+                                    int r1, int c1, bool net){
+        size_t width = static_cast<size_t>(n) + 1;
+        RowMaxKernel row_max = row_max_kernel();
+        const int* top = &pref[static_cast<size_t>(r1) * width];
+        Candidate best;
+
+        for (int r2 = r1; r2 < m; ++r2){
+            int height = r2 - r1 + 1;
+            const int* bottom = &pref[static_cast<size_t>(r2 + 1) * width];
+            int base = bottom[c1] - top[c1];
+            // Score of column k = c2 + 1 is kernel value + offset.
+            int mul = net ? 2 : 1;
+            int slope = net ? height : 0;
+            int offset = net ? height * c1 - 2 * base : -base;
+            RowMax row = row_max(bottom, top, c1 + 1, n + 1, mul, slope, best.cover - offset);
+            if (row.index >= 0) {
+                best.cover = row.value + offset;
+                best.rect = {r1, c1, r2, row.index - 1};
+            }
+        }
+        return best;
+    }
+
+    // Best rectangle over every set anchor in row r1, in (c1, r2, c2) order.
+    static Candidate best_in_row(const BitMatrix& bits, const vector<int>& pref,
+                                 int r1, bool net){
+        int m = bits.rows();
+        int n = bits.cols();
+        Candidate best;
+
+        for (int c1 = 0; c1 < n; ++c1){
+            if (!bits.get(r1, c1)) continue;
+
+            Candidate anchored = best_at_anchor(pref, m, n, r1, c1, net);
+            if (anchored.cover > best.cover) best = anchored;
+        }
+        return best;
+    }
+
+    // Rows are scored independently (in parallel when a pool is given) and
+    // reduced in row order, which yields the same rectangle as one serial
+    // scan in (r1, c1, r2, c2) order.
+    static Candidate best_candidate(const BitMatrix& bits, const vector<int>& pref,
+                                    bool net, ThreadPool* pool, vector<Candidate>& per_row){
+        int m = bits.rows();
+        Candidate best;
+        if (!pool || m < PARALLEL_MIN_ROWS) {
+            for (int r1 = 0; r1 < m; ++r1){
+                Candidate row = best_in_row(bits, pref, r1, net);
+                if (row.cover > best.cover) best = row;
+            }
+            return best;
+        }
+
+        per_row.assign(m, Candidate());
+        pool->parallel_for(m, [&](int r1, int){
+            per_row[r1] = best_in_row(bits, pref, r1, net);
+        });
+        for (const Candidate& row : per_row){
+            if (row.cover > best.cover) best = row;
+        }
+        return best;
+    }
+
+    static bool rect_less(const Rect& a, const Rect& b){
+        if (a.r1 != b.r1) return a.r1 < b.r1;
+        if (a.c1 != b.c1) return a.c1 < b.c1;
+        if (a.r2 != b.r2) return a.r2 < b.r2;
+        return a.c2 < b.c2;
+    }
+
+    // Largest all-ones rectangle, found with the largest-rectangle-in-a-
+    // histogram stack over every row: O(mn) per call. Each popped bar is a
+    // rectangle that cannot grow left, right or up. Equal areas resolve to
+    // the smallest (r1, c1, r2, c2) so the result does not depend on pop
+    // order. `heights` and `stack` are scratch.
+    static Candidate best_maximal(const BitMatrix& bits, vector<int>& heights,
+                                  vector<int>& stack, [[maybe_unused]] SolveStats* stats){
+        int m = bits.rows();
+        int n = bits.cols();
+        Candidate best;
+        heights.assign(static_cast<size_t>(n) + 1, 0);
+
+        for (int i = 0; i < m; ++i){
+            for (int j = 0; j < n; ++j){
+                heights[j] = bits.get(i, j) ? heights[j] + 1 : 0;
+            }
+            stack.clear();
+            for (int j = 0; j <= n; ++j){
+                while (!stack.empty() && heights[stack.back()] >= heights[j]){
+                    int h = heights[stack.back()];
+                    stack.pop_back();
+                    if (h == 0) continue;
+                    STATS(++stats->candidates_scanned);
+                    int left = stack.empty() ? 0 : stack.back() + 1;
+                    Rect rect{i - h + 1, left, i, j - 1};
+                    int area = h * (j - left);
+                    if (area > best.cover ||
+                        (area == best.cover && rect_less(rect, best.rect))) {
+                        best.cover = area;
+                        best.rect = rect;
+                    }
+                }
+                stack.push_back(j);
+            }
+        }
+        return best;
     }
 
-    int solve(int m, int n, vector<vector<bool>> matrix){
-        if (m == 0 || n == 0) return 0;
+    // Heap order for LAZY: larger cover first, then the smaller anchor, which
+    // is the order a serial scan would prefer between equal covers.
+    static bool lazy_lower(const LazyEntry& a, const LazyEntry& b){
+        if (a.key != b.key) return a.key < b.key;
+        return a.anchor > b.anchor;
+    }
+
+    // Ones in the quadrant below and right of (r1, c1). Covers only grow
+    // with a rectangle, so this is the best cover any rectangle anchored
+    // there can reach, and an upper bound on its best net gain.
+    static int quadrant_cover(const vector<int>& pref, int m, int n, int r1, int c1){
+        return sum_rect(pref, static_cast<size_t>(n) + 1, r1, c1, m - 1, n - 1);
+    }
+
+    // First rectangle in (r2, c2) order anchored at (r1, c1) whose cover
+    // reaches `cover`, the anchor's quadrant cover: the same rectangle
+    // best_at_anchor() returns. Both searches run over monotone sums.
+    static Rect locate_at_anchor(const vector<int>& pref, int m, int n,
+                                 int r1, int c1, int cover, [[maybe_unused]] SolveStats* stats){
+        size_t width = static_cast<size_t>(n) + 1;
+        int lo = r1, hi = m - 1;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            STATS(++stats->candidates_scanned);
+            if (sum_rect(pref, width, r1, c1, mid, n - 1) >= cover) hi = mid;
+            else lo = mid + 1;
+        }
+        int r2 = lo;
+        lo = c1;
+        hi = n - 1;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            STATS(++stats->candidates_scanned);
+            if (sum_rect(pref, width, r1, c1, r2, mid) >= cover) hi = mid;
+            else lo = mid + 1;
+        }
+        return {r1, c1, r2, lo};
+    }
+
+    static void lazy_push(Scratch& scratch, int anchor, int key){
+        scratch.anchor_best[anchor].cover = key;
+        scratch.anchor_fresh[anchor] = false;
+        uint32_t version = ++scratch.anchor_version[anchor];
+        scratch.heap.push_back({key, anchor, version});
+        push_heap(scratch.heap.begin(), scratch.heap.end(), lazy_lower);
+    }
+
+    static void lazy_init(Scratch& scratch){
+        const BitMatrix& bits = scratch.bits;
+        int m = bits.rows();
+        int n = bits.cols();
+        size_t cells = static_cast<size_t>(m) * n;
+        scratch.heap.clear();
+        scratch.anchor_best.assign(cells, Candidate());
+        scratch.anchor_version.assign(cells, 0);
+        scratch.anchor_fresh.assign(cells, 0);
+        for (int r1 = 0; r1 < m; ++r1){
+            for (int c1 = 0; c1 < n; ++c1){
+                if (!bits.get(r1, c1)) continue;
+                lazy_push(scratch, r1 * n + c1, quadrant_cover(scratch.pref, m, n, r1, c1));
+            }
+        }
+    }
+
+    // Under COVER, keys are exact covers, so the live heap top is the anchor
+    // EXHAUSTIVE would pick. Only its rectangle still has to be located, and
+    // that is cached until a flip touches the anchor's quadrant.
+    //
+    // Under NET_GAIN, keys of anchors that are not fresh are quadrant
+    // covers, which only bound the net gain. Such a top is scanned, re-keyed
+    // with its exact score and pushed back; the first fresh top then beats
+    // every bound below it, and ties still go to the smaller anchor.
+    static Candidate lazy_best(Scratch& scratch, bool net, SolveStats* stats){
+        const BitMatrix& bits = scratch.bits;
+        int m = bits.rows();
+        int n = bits.cols();
+        vector<LazyEntry>& heap = scratch.heap;
+        while (!heap.empty()) {
+            const LazyEntry& top = heap.front();
+            if (top.version != scratch.anchor_version[top.anchor]) {
+                pop_heap(heap.begin(), heap.end(), lazy_lower);
+                heap.pop_back();
+                continue;
+            }
+            Candidate& best = scratch.anchor_best[top.anchor];
+            if (net && !scratch.anchor_fresh[top.anchor]) {
+                int anchor = top.anchor;
+                STATS(stats->candidates_scanned +=
+                      static_cast<uint64_t>(m - anchor / n) * (n - anchor % n));
+                Candidate exact = best_at_anchor(scratch.pref, m, n, anchor / n,
+                                                 anchor % n, true);
+                lazy_push(scratch, anchor, exact.cover);
+                best = exact;
+                scratch.anchor_fresh[anchor] = true;
+                continue;
+            }
+            if (!scratch.anchor_fresh[top.anchor]) {
+                best.rect = locate_at_anchor(scratch.pref, m, n, top.anchor / n,
+                                             top.anchor % n, best.cover, stats);
+                scratch.anchor_fresh[top.anchor] = true;
+            }
+            return best;
+        }
+        return Candidate();
+    }
+
+    // Re-key anchors after `flipped` has been applied. Only anchors above
+    // and left of its bottom-right corner own rectangles that overlap it;
+    // the rest keep both their key and their cached rectangle. Anchors
+    // inside it switch between set and unset.
+    static void lazy_after_flip(Scratch& scratch, const Rect& flipped, bool net){
+        const BitMatrix& bits = scratch.bits;
+        int m = bits.rows();
+        int n = bits.cols();
+
+        for (int r1 = 0; r1 <= flipped.r2; ++r1){
+            for (int c1 = 0; c1 <= flipped.c2; ++c1){
+                int anchor = r1 * n + c1;
+                if (!bits.get(r1, c1)) {
+                    if (r1 >= flipped.r1 && c1 >= flipped.c1) ++scratch.anchor_version[anchor];
+                    continue;
+                }
+                int key = quadrant_cover(scratch.pref, m, n, r1, c1);
+                bool listed = r1 < flipped.r1 || c1 < flipped.c1;
+                if (!net && listed && key == scratch.anchor_best[anchor].cover) {
+                    scratch.anchor_fresh[anchor] = false;
+                } else {
+                    lazy_push(scratch, anchor, key);
+                }
+            }
+        }
+
+        // Drop dead entries once they outnumber the anchors.
+        vector<LazyEntry>& heap = scratch.heap;
+        if (heap.size() > 2 * scratch.anchor_version.size() + 1024) {
+            heap.erase(remove_if(heap.begin(), heap.end(), [&](const LazyEntry& e){
+                return e.version != scratch.anchor_version[e.anchor];
+            }), heap.end());
+            make_heap(heap.begin(), heap.end(), lazy_lower);
+        }
+    }
+
+    // Cell (i, j) of the corner grid is the XOR of matrix cells
+    // (i-1..i, j-1..j), out-of-range cells being zero. Built with one XOR
+    // and one shift per word.
+    void build_corners(const BitMatrix& bits, BitMatrix& corners){
+        int m = bits.rows();
+        int n = bits.cols();
+        corners.reset(m + 1, n + 1);
+        size_t stride = corners.stride();
+        for (int i = 0; i <= m; ++i) {
+            const uint64_t* cur = i < m ? bits.row(i) : nullptr;
+            const uint64_t* prev = i > 0 ? bits.row(i - 1) : nullptr;
+            uint64_t* out = corners.row(i);
+            uint64_t carry = 0;
+            for (size_t k = 0; k < stride; ++k) {
+                uint64_t v = 0;
+                if (k < bits.stride()) v = (cur ? cur[k] : 0) ^ (prev ? prev[k] : 0);
+                out[k] = v ^ (v << 1) ^ carry;
+                carry = v >> (BitMatrix::WORD_BITS - 1);
+            }
+        }
+    }
+
+    // First column >= from set in row a and, when b is given, in row b too;
+    // -1 if there is none.
+    static int first_common(const uint64_t* a, const uint64_t* b, size_t stride, int from){
+        for (size_t k = from / BitMatrix::WORD_BITS; k < stride; ++k) {
+            uint64_t w = b ? a[k] & b[k] : a[k];
+            if (k == static_cast<size_t>(from / BitMatrix::WORD_BITS)) {
+                w &= ~uint64_t(0) << (from % BitMatrix::WORD_BITS);
+            }
+            if (w) return static_cast<int>(k) * BitMatrix::WORD_BITS + __builtin_ctzll(w);
+        }
+        return -1;
+    }
+
+    // CORNER strategy. Every row and column of the corner grid holds an
+    // even number of odd cells, so the first odd corner (r, c) always has a
+    // partner (r, c') to its right and (r', c) below it. Flipping
+    // (r, c, r'-1, c'-1) clears those three and toggles (r', c'); a
+    // partner pair with (r', c') odd as well is preferred, clearing four.
+    // Each flip removes at least two odd corners, so the plan is at most
+    // twice corner_lower_bound().
+    static int solve_corner(Scratch& scratch, [[maybe_unused]] SolveStats* stats, vector<Rect>* plan){
+        BitMatrix& d = scratch.corners;
+        build_corners(scratch.bits, d);
+        int rows = d.rows();
+        size_t stride = d.stride();
+
+        int flips = 0;
+        for (int r = 0; r < rows; ++r) {
+            uint64_t* top = d.row(r);
+            int from = 0;
+            int c;
+            while ((c = first_common(top, nullptr, stride, from)) >= 0) {
+                from = c + 1;
+                int r2 = -1, c2 = -1;
+                for (int below = r + 1; below < rows; ++below) {
+                    if (!d.get(below, c)) continue;
+                    STATS(++stats->candidates_scanned);
+                    int quad = first_common(top, d.row(below), stride, c + 1);
+                    if (r2 < 0 || quad >= 0) {
+                        r2 = below;
+                        c2 = quad;
+                    }
+                    if (quad >= 0) break;
+                }
+                if (c2 < 0) c2 = first_common(top, nullptr, stride, c + 1);
+                if (r2 < 0 || c2 < 0) {
+                    throw std::runtime_error("corner grid lost its parity");
+                }
+
+                d.set(r, c, false);
+                d.set(r, c2, !d.get(r, c2));
+                d.set(r2, c, !d.get(r2, c));
+                d.set(r2, c2, !d.get(r2, c2));
+                STATS(++stats->iterations);
+                if (plan) plan->push_back({r, c, r2 - 1, c2 - 1});
+                ++flips;
+            }
+        }
+        scratch.bits.clear();
+        return flips;
+    }
+
+    void load_matrix(int m, int n, const vector<vector<bool>>& matrix, BitMatrix& bits){
         if (m < 0 || n < 0) {
             throw std::invalid_argument("m < 0 or n < 0");
         }
-        if (m != matrix.size()) {
+        if (static_cast<size_t>(m) != matrix.size()) {
             throw std::invalid_argument("m != matrix.size()");
         }
         for (int i = 0; i < m; ++i) {
@@ -54,56 +475,443 @@ namespace solution {
               throw std::invalid_argument("row “i” length != n");
             }
         }
-        if (!matrix_has_ones(matrix)) return 0;
 
-        vector<Rect> rects;
-        rects.reserve((m * (m + 1) / 2) * (n * (n + 1) / 2));
-        for (int r1 = 0; r1 < m; ++r1){
-            for (int c1 = 0; c1 < n; ++c1){
-                for (int r2 = r1; r2 < m; ++r2){
-                    for (int c2 = c1; c2 < n; ++c2){
-                        rects.push_back({r1, c1, r2, c2});
-                    }
-                }
+        bits.reset(m, n);
+        for (int i = 0; i < m; ++i) {
+            for (int j = 0; j < n; ++j) {
+                if (matrix[i][j]) bits.set(i, j, true);
             }
         }
+    }
 
-        vector<vector<int>> pref(m + 1, vector<int>(n + 1, 0));
+    using SmallSolver = int (*)(uint64_t, vector<Rect>*, Scoring);
 
-        int flips = 0;
-        while (matrix_has_ones(matrix)) {
-            build_pref(matrix, pref);
-            int best_idx   = -1;
-            int best_cover = -1;
+    template <size_t... I>
+    static constexpr array<SmallSolver, sizeof...(I)> small_solvers(index_sequence<I...>){
+        return {{&solve<static_cast<int>(I / 8 + 1), static_cast<int>(I % 8 + 1)>...}};
+    }
+
+    // solve<M, N> for every 1 <= M, N <= 8, at index (M - 1) * 8 + N - 1.
+    static constexpr array<SmallSolver, 64> SMALL_SOLVERS =
+        small_solvers(make_index_sequence<64>());
+
+    int solve_small(int m, int n, uint64_t state, vector<Rect>* plan, Scoring scoring){
+        if (m < 1 || m > 8 || n < 1 || n > 8) {
+            throw std::invalid_argument("solve_small needs 1 <= m, n <= 8");
+        }
+        return SMALL_SOLVERS[(m - 1) * 8 + (n - 1)](state, plan, scoring);
+    }
+
+    // Merge runs of equal adjacent rows and columns of bits into reduced.
+    // A column equals its left neighbour when no kept row has a bit change
+    // there, found with one shift and XOR per word.
+    static void dedup_matrix(const BitMatrix& bits, BitMatrix& reduced,
+                             vector<int>& row_start, vector<int>& col_start,
+                             vector<uint64_t>& changes){
+        int m = bits.rows();
+        int n = bits.cols();
+        size_t stride = bits.stride();
+
+        row_start.clear();
+        for (int i = 0; i < m; ++i){
+            if (i == 0 || memcmp(bits.row(i), bits.row(i - 1), stride * sizeof(uint64_t)) != 0){
+                row_start.push_back(i);
+            }
+        }
 
-            for (size_t i = 0; i < rects.size(); ++i) {
-                Rect& curr_rect = rects[i];
+        changes.assign(stride, 0);
+        for (int start : row_start){
+            const uint64_t* p = bits.row(start);
+            uint64_t carry = 0;
+            for (size_t k = 0; k < stride; ++k){
+                changes[k] |= p[k] ^ ((p[k] << 1) | carry);
+                carry = p[k] >> (BitMatrix::WORD_BITS - 1);
+            }
+        }
+        col_start.clear();
+        for (int j = 0; j < n; ++j){
+            if (j == 0 || ((changes[j / BitMatrix::WORD_BITS] >> (j % BitMatrix::WORD_BITS)) & 1)){
+                col_start.push_back(j);
+            }
+        }
 
-                if (!matrix[curr_rect.r1][curr_rect.c1]) continue;
+        int rows = static_cast<int>(row_start.size());
+        int cols = static_cast<int>(col_start.size());
+        reduced.reset(rows, cols);
+        for (int i = 0; i < rows; ++i){
+            for (int j = 0; j < cols; ++j){
+                if (bits.get(row_start[i], col_start[j])) reduced.set(i, j, true);
+            }
+        }
+        row_start.push_back(m);
+        col_start.push_back(n);
+    }
 
-                int cover = sum_rect(pref, curr_rect.r1, curr_rect.c1,
-                                     curr_rect.r2, curr_rect.c2);
+    // Ones of row r of bits in columns c1..c2.
+    static int count_in_row(const BitMatrix& bits, int r, int c1, int c2){
+        const uint64_t* p = bits.row(r);
+        size_t w1 = c1 / BitMatrix::WORD_BITS;
+        size_t w2 = c2 / BitMatrix::WORD_BITS;
+        uint64_t head = ~uint64_t(0) << (c1 % BitMatrix::WORD_BITS);
+        uint64_t tail = ~uint64_t(0) >> (BitMatrix::WORD_BITS - 1 - c2 % BitMatrix::WORD_BITS);
+        if (w1 == w2) return __builtin_popcountll(p[w1] & head & tail);
+        int total = __builtin_popcountll(p[w1] & head) + __builtin_popcountll(p[w2] & tail);
+        for (size_t k = w1 + 1; k < w2; ++k) total += __builtin_popcountll(p[k]);
+        return total;
+    }
 
-                if (cover > best_cover) {
-                    best_cover = cover;
-                    best_idx = static_cast<int>(i);
+    // Coarse matrix of block x block cells of bits (smaller at the bottom
+    // and right edges); a cell is set when more than half its block is.
+    static void downsample(const BitMatrix& bits, int block, BitMatrix& coarse,
+                           vector<int>& ones){
+        int m = bits.rows();
+        int n = bits.cols();
+        int rows = (m + block - 1) / block;
+        int cols = (n + block - 1) / block;
+        coarse.reset(rows, cols);
+        ones.assign(cols, 0);
+        for (int i = 0; i < rows; ++i){
+            int r1 = i * block, r2 = min(m, r1 + block) - 1;
+            fill(ones.begin(), ones.end(), 0);
+            for (int r = r1; r <= r2; ++r){
+                for (int j = 0; j < cols; ++j){
+                    ones[j] += count_in_row(bits, r, j * block, min(n, (j + 1) * block) - 1);
                 }
             }
+            for (int j = 0; j < cols; ++j){
+                int area = (r2 - r1 + 1) * (min(n, (j + 1) * block) - j * block);
+                if (2 * ones[j] > area) coarse.set(i, j, true);
+            }
+        }
+    }
+
+    // Net gain of flipping column c over rows r1..r2.
+    static int column_gain(const BitMatrix& bits, int c, int r1, int r2){
+        int ones = 0;
+        for (int r = r1; r <= r2; ++r) ones += bits.get(r, c);
+        return 2 * ones - (r2 - r1 + 1);
+    }
 
-            if (best_cover <= 0 || best_idx < 0 || best_idx >= rects.size()) {
-                throw std::runtime_error("Invalid best_cover or best_idx");
+    // Move each edge of a lifted rectangle by up to `slack` cells, one row
+    // or column at a time, while that raises its net gain on bits: grow
+    // over lines that are mostly ones, shrink off lines that are mostly
+    // zeros. Block edges rarely match the regions they approximate; this
+    // keeps the slivers between them out of the residual.
+    static void refine_edges(const BitMatrix& bits, int slack, Rect& rect){
+        int m = bits.rows();
+        int n = bits.cols();
+        const Rect start = rect;
+        bool moved = true;
+        while (moved) {
+            moved = false;
+            if (rect.r1 > max(0, start.r1 - slack) &&
+                2 * count_in_row(bits, rect.r1 - 1, rect.c1, rect.c2) > rect.c2 - rect.c1 + 1) {
+                --rect.r1;
+                moved = true;
+            } else if (rect.r1 < min(rect.r2, start.r1 + slack) &&
+                       2 * count_in_row(bits, rect.r1, rect.c1, rect.c2) < rect.c2 - rect.c1 + 1) {
+                ++rect.r1;
+                moved = true;
+            }
+            if (rect.r2 < min(m - 1, start.r2 + slack) &&
+                2 * count_in_row(bits, rect.r2 + 1, rect.c1, rect.c2) > rect.c2 - rect.c1 + 1) {
+                ++rect.r2;
+                moved = true;
+            } else if (rect.r2 > max(rect.r1, start.r2 - slack) &&
+                       2 * count_in_row(bits, rect.r2, rect.c1, rect.c2) < rect.c2 - rect.c1 + 1) {
+                --rect.r2;
+                moved = true;
+            }
+            if (rect.c1 > max(0, start.c1 - slack) &&
+                column_gain(bits, rect.c1 - 1, rect.r1, rect.r2) > 0) {
+                --rect.c1;
+                moved = true;
+            } else if (rect.c1 < min(rect.c2, start.c1 + slack) &&
+                       column_gain(bits, rect.c1, rect.r1, rect.r2) < 0) {
+                ++rect.c1;
+                moved = true;
+            }
+            if (rect.c2 < min(n - 1, start.c2 + slack) &&
+                column_gain(bits, rect.c2 + 1, rect.r1, rect.r2) > 0) {
+                ++rect.c2;
+                moved = true;
+            } else if (rect.c2 > max(rect.c1, start.c2 - slack) &&
+                       column_gain(bits, rect.c2, rect.r1, rect.r2) < 0) {
+                --rect.c2;
+                moved = true;
             }
+        }
+    }
+
+    // Body of solve_packed(). The coarse and dedup passes recurse into it,
+    // so stats accumulate over every pass of one call.
+    static int greedy_packed(Scratch& scratch, const SolveOptions& options, ThreadPool* pool,
+                             vector<Rect>* plan){
+        int block = options.coarse_block;
+        if (block > 1 && (scratch.bits.rows() > block || scratch.bits.cols() > block)) {
+            BitMatrix& bits = scratch.bits;
+            int m = bits.rows();
+            int n = bits.cols();
+            SolveOptions fine = options;
+            fine.coarse_block = 0;
 
-            Rect& best_rect = rects[best_idx];
-            for (int r = best_rect.r1; r <= best_rect.r2; ++r){
-                for (int c = best_rect.c1; c <= best_rect.c2; ++c){
-                    matrix[r][c] = !matrix[r][c];
+            if (!scratch.coarse) scratch.coarse.reset(new Scratch());
+            downsample(bits, block, scratch.coarse->bits, scratch.block_ones);
+            vector<Rect>& lifted = scratch.lifted;
+            lifted.clear();
+            greedy_packed(*scratch.coarse, fine, pool, &lifted);
+            for (Rect& rect : lifted){
+                rect = {rect.r1 * block, rect.c1 * block,
+                        min(m, (rect.r2 + 1) * block) - 1, min(n, (rect.c2 + 1) * block) - 1};
+                refine_edges(bits, block - 1, rect);
+                bits.flip_rect(rect.r1, rect.c1, rect.r2, rect.c2);
+            }
+            if (plan) plan->insert(plan->end(), lifted.begin(), lifted.end());
+            return static_cast<int>(lifted.size()) + greedy_packed(scratch, fine, pool, plan);
+        }
+        if (options.dedup && scratch.bits.rows() > 0 && scratch.bits.cols() > 0) {
+            dedup_matrix(scratch.bits, scratch.reduced, scratch.row_start, scratch.col_start,
+                         scratch.col_changes);
+            scratch.bits.clear();
+            swap(scratch.bits, scratch.reduced);
+            SolveOptions merged = options;
+            merged.dedup = false;
+            size_t first = plan ? plan->size() : 0;
+            int flips = greedy_packed(scratch, merged, pool, plan);
+            swap(scratch.bits, scratch.reduced);
+            if (plan) {
+                for (size_t k = first; k < plan->size(); ++k){
+                    Rect& rect = (*plan)[k];
+                    rect = {scratch.row_start[rect.r1], scratch.col_start[rect.c1],
+                            scratch.row_start[rect.r2 + 1] - 1, scratch.col_start[rect.c2 + 1] - 1};
                 }
             }
+            return flips;
+        }
+
+        BitMatrix& bits = scratch.bits;
+        SolveStats* stats = options.stats;
+        int m = bits.rows();
+        int n = bits.cols();
+        if (m == 0 || n == 0 || !matrix_has_ones(bits)) return 0;
+        bool net = options.scoring == Scoring::NET_GAIN;
+
+        // Up to 8x8 the whole matrix fits in one word. EXHAUSTIVE and LAZY
+        // make identical choices, so both can take the specialized solver,
+        // unless the caller is collecting stats.
+        bool collecting = STATS_ENABLED && stats;
+        bool scanning = options.strategy == Strategy::EXHAUSTIVE ||
+                        options.strategy == Strategy::LAZY;
+        if (m <= 8 && n <= 8 && scanning && !collecting) {
+            uint64_t state = 0;
+            for (int i = 0; i < m; ++i) state |= bits.row(i)[0] << (i * n);
+            bits.clear();
+            return solve_small(m, n, state, plan, options.scoring);
+        }
+
+        if (options.strategy == Strategy::CORNER) return solve_corner(scratch, stats, plan);
+
+        size_t width = static_cast<size_t>(n) + 1;
+        vector<int>& pref = scratch.pref;
+        STATS_CLOCK(start);
+        pref.assign((static_cast<size_t>(m) + 1) * width, 0);
+        scratch.acc.assign(width, 0);
+        build_pref(bits, pref);
+        STATS(stats->build_pref_ns += elapsed_ns(start));
+        if (options.strategy == Strategy::LAZY) lazy_init(scratch);
+
+        int flips = 0;
+        while (pref.back() > 0) {
+            STATS(start = chrono::steady_clock::now());
+            Candidate best;
+            switch (options.strategy) {
+            case Strategy::MAXIMAL:
+                best = best_maximal(bits, scratch.heights, scratch.stack, stats);
+                break;
+            case Strategy::LAZY:
+                best = lazy_best(scratch, net, stats);
+                break;
+            default:
+                best = best_candidate(bits, pref, net, pool, scratch.per_row);
+                break;
+            }
+            STATS(stats->score_ns += elapsed_ns(start));
+
+            if (best.cover <= 0 || best.rect.r1 < 0) {
+                throw std::runtime_error("Invalid best_cover or best_rect");
+            }
+            STATS(
+                if (options.strategy == Strategy::EXHAUSTIVE) count_candidates(bits, stats);
+                ++stats->iterations;
+                stats->best_cover.push_back(best.cover)
+            );
+
+            STATS(start = chrono::steady_clock::now());
+            const Rect& best_rect = best.rect;
+            bits.flip_rect(best_rect.r1, best_rect.c1, best_rect.r2, best_rect.c2);
+            update_pref(bits, pref, scratch.acc, best_rect);
+            if (options.strategy == Strategy::LAZY) lazy_after_flip(scratch, best_rect, net);
+            STATS(stats->flip_ns += elapsed_ns(start));
+            if (plan) plan->push_back(best_rect);
 
             ++flips;
         }
 
         return flips;
     }
-}   
\ No newline at end of file
+
+    void reset_stats(const SolveOptions& options){
+        [[maybe_unused]] SolveStats* stats = options.stats;
+        STATS(*stats = SolveStats());
+    }
+
+    int solve_packed(Scratch& scratch, const SolveOptions& options, ThreadPool* pool,
+                     vector<Rect>* plan){
+        reset_stats(options);
+        return greedy_packed(scratch, options, pool, plan);
+    }
+
+    ThreadPool* scan_pool(const SolveOptions& options, int m){
+        if (options.threads == 1 || options.strategy != Strategy::EXHAUSTIVE ||
+            m < PARALLEL_MIN_ROWS) {
+            return nullptr;
+        }
+        // A pool runs one loop at a time, so concurrent callers each keep
+        // their own. It is rebuilt only when the thread count changes.
+        thread_local int threads = 1;
+        thread_local unique_ptr<ThreadPool> pool;
+        if (!pool || threads != options.threads) {
+            pool.reset();
+            pool.reset(new ThreadPool(options.threads));
+            threads = options.threads;
+        }
+        return pool->size() > 1 ? pool.get() : nullptr;
+    }
+
+    // Greedy on a loaded or attached scratch.bits.
+    static int solve_loaded(Scratch& scratch, const SolveOptions& options){
+        if (!matrix_has_ones(scratch.bits)) {
+            reset_stats(options);
+            return 0;
+        }
+
+        return solve_packed(scratch, options, scan_pool(options, scratch.bits.rows()));
+    }
+
+    void check_view(int rows, int cols, size_t stride, size_t min_stride, const void* data){
+        if (rows < 0 || cols < 0) {
+            throw std::invalid_argument("rows < 0 or cols < 0");
+        }
+        if (rows > 0 && cols > 0 && (stride < min_stride || !data)) {
+            throw std::invalid_argument("view stride too small or data null");
+        }
+    }
+
+    int solve(int m, int n, const vector<vector<bool>>& matrix){
+        return solve(m, n, matrix, SolveOptions());
+    }
+
+    int solve(int m, int n, const vector<vector<bool>>& matrix, const SolveOptions& options){
+        if (m == 0 || n == 0) {
+            reset_stats(options);
+            return 0;
+        }
+
+        Scratch scratch;
+        load_matrix(m, n, matrix, scratch.bits);
+        return solve_loaded(scratch, options);
+    }
+
+    int solve(const ByteMatrixView& view, const SolveOptions& options){
+        check_view(view.rows, view.cols, view.stride, static_cast<size_t>(view.cols), view.data);
+        if (view.rows == 0 || view.cols == 0) {
+            reset_stats(options);
+            return 0;
+        }
+
+        Scratch scratch;
+        scratch.bits.load_bytes(view.data, view.rows, view.cols, view.stride);
+        return solve_loaded(scratch, options);
+    }
+
+    int solve(const PackedMatrixView& view, const SolveOptions& options){
+        size_t words = (static_cast<size_t>(view.cols) + BitMatrix::WORD_BITS - 1) /
+                       BitMatrix::WORD_BITS;
+        check_view(view.rows, view.cols, view.stride, words, view.words);
+        if (view.rows == 0 || view.cols == 0) {
+            reset_stats(options);
+            return 0;
+        }
+
+        Scratch scratch;
+        scratch.bits.load(view.words, view.rows, view.cols, view.stride);
+        return solve_loaded(scratch, options);
+    }
+
+    int solve_in_place(int rows, int cols, uint64_t* words, size_t stride,
+                       const SolveOptions& options){
+        size_t used = (static_cast<size_t>(cols) + BitMatrix::WORD_BITS - 1) /
+                      BitMatrix::WORD_BITS;
+        check_view(rows, cols, stride, used, words);
+        if (rows == 0 || cols == 0) {
+            reset_stats(options);
+            return 0;
+        }
+
+        Scratch scratch;
+        scratch.bits.attach(words, rows, cols, stride);
+        return solve_loaded(scratch, options);
+    }
+
+    Plan solve_with_plan(int m, int n, const vector<vector<bool>>& matrix,
+                         const SolveOptions& options){
+        Plan plan;
+        solve_with_plan(m, n, matrix, options, plan);
+        return plan;
+    }
+
+    void solve_with_plan(int m, int n, const vector<vector<bool>>& matrix,
+                         const SolveOptions& options, Plan& plan){
+        plan.flips = 0;
+        plan.rects.clear();
+        if (m == 0 || n == 0) {
+            reset_stats(options);
+            return;
+        }
+
+        Scratch scratch;
+        load_matrix(m, n, matrix, scratch.bits);
+        if (!matrix_has_ones(scratch.bits)) {
+            reset_stats(options);
+            return;
+        }
+
+        ThreadPool* pool = scan_pool(options, m);
+        // One slot per set cell is only a first guess: COVER can set zeros,
+        // so a run may flip more rectangles than that and regrow the plan.
+        // Callers that pass the same Plan again keep its grown capacity.
+        plan.rects.reserve(scratch.bits.count());
+        plan.flips = solve_packed(scratch, options, pool, &plan.rects);
+    }
+
+    int corner_lower_bound(int m, int n, const vector<vector<bool>>& matrix){
+        BitMatrix bits, corners;
+        load_matrix(m, n, matrix, bits);
+        build_corners(bits, corners);
+        return static_cast<int>((corners.count() + 3) / 4);
+    }
+
+    bool verify_plan(int m, int n, const vector<vector<bool>>& matrix,
+                     const vector<Rect>& plan){
+        BitMatrix bits;
+        load_matrix(m, n, matrix, bits);
+        for (const Rect& rect : plan) {
+            if (rect.r1 < 0 || rect.c1 < 0 || rect.r1 > rect.r2 || rect.c1 > rect.c2 ||
+                rect.r2 >= m || rect.c2 >= n) {
+                return false;
+            }
+            bits.flip_rect(rect.r1, rect.c1, rect.r2, rect.c2);
+        }
+        return !matrix_has_ones(bits);
+    }
+}   
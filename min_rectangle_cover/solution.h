@@ -1,9 +1,335 @@
 #ifndef SOLUTION_H
 #define SOLUTION_H
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <vector>
 using namespace std;
 
 namespace solution {
-int solve(int m, int n, vector<vector<bool>> matrix);
+// Inclusive cell range rows r1..r2, columns c1..c2.
+struct Rect {
+    int r1, c1, r2, c2;
+};
+
+// Flip sequence chosen by the solver; flips == rects.size().
+struct Plan {
+    int flips = 0;
+    vector<Rect> rects;
+};
+
+enum class Strategy {
+    // Score every rectangle anchored at a set cell and flip the one covering
+    // the most ones.
+    EXHAUSTIVE,
+    // Same choices as EXHAUSTIVE. Anchors live in a max-heap keyed on their
+    // best cover (an upper bound under NET_GAIN, tightened when it reaches
+    // the top); a flip re-keys only the anchors whose rectangles overlap
+    // it, and the winning rectangle is located only for the heap top.
+    LAZY,
+    // Flip the largest all-ones rectangle. O(mn) per iteration; never turns
+    // a zero into a one, so it often needs fewer flips than EXHAUSTIVE.
+    MAXIMAL,
+    // Work on the corner grid (see corner_lower_bound()): flip rectangles
+    // whose corners pair up odd corners, clearing three or four of them per
+    // flip. O(m * n / 64) per flip and never more than twice the lower
+    // bound. Ignores Scoring and threads.
+    CORNER
+};
+
+// How EXHAUSTIVE and LAZY score a rectangle. MAXIMAL only flips all-ones
+// rectangles, where both rules agree.
+enum class Scoring {
+    // Ones inside the rectangle.
+    COVER,
+    // Ones minus zeros inside it: the drop in the number of ones the flip
+    // causes. Never picks a rectangle that creates more ones than it
+    // clears, so later iterations undo less damage.
+    NET_GAIN
+};
+
+// Hot-path counters filled in by solve() when this directory is compiled
+// with -DRECT_COVER_STATS. Without that flag the recording code is not
+// compiled at all and the struct is left untouched.
+struct SolveStats {
+    uint64_t iterations = 0;
+    // Rectangles scored (EXHAUSTIVE), histogram bars popped (MAXIMAL) or
+    // partner rows tried (CORNER).
+    uint64_t candidates_scanned = 0;
+    // Rectangles never scored because their anchor cell is zero.
+    uint64_t candidates_skipped = 0;
+    uint64_t build_pref_ns = 0;
+    uint64_t score_ns = 0;
+    uint64_t flip_ns = 0;
+    // Score (see Scoring) of the rectangle flipped in each iteration.
+    vector<int> best_cover;
+};
+
+#ifdef RECT_COVER_STATS
+constexpr bool STATS_ENABLED = true;
+#else
+constexpr bool STATS_ENABLED = false;
+#endif
+
+struct SolveOptions {
+    Strategy strategy = Strategy::EXHAUSTIVE;
+    Scoring scoring = Scoring::COVER;
+
+    // Worker threads for the EXHAUSTIVE scan; 0 uses every hardware thread.
+    // Matrices under 16 rows are scanned serially, and the free functions
+    // keep one pool per calling thread between calls. Results do not
+    // depend on this value.
+    int threads = 1;
+
+    // Merge runs of equal adjacent rows, then of equal adjacent columns,
+    // solve the smaller matrix and map the plan back to original cells.
+    // The optimal flip count is unchanged by the merge; the greedy's own
+    // count may move either way, since merged cells lose their weight.
+    bool dedup = false;
+
+    // When > 1 and the matrix is larger than one block, first solve a
+    // coarse matrix with one cell per coarse_block x coarse_block block,
+    // set when most of the block is set. Its rectangles are lifted to full
+    // resolution, their edges nudged by less than a block towards the
+    // regions they approximate, and the greedy then runs on what they
+    // leave. The other options apply to both runs. Pays off on large
+    // matrices made of large regions, most with MAXIMAL or NET_GAIN.
+    int coarse_block = 0;
+
+    // Reset and filled per call when STATS_ENABLED; ignored otherwise.
+    SolveStats* stats = nullptr;
+};
+
+struct ExactOptions {
+    // Stop after this many search nodes; 0 means no limit.
+    uint64_t node_budget = 0;
+    // Stop after this many milliseconds; 0 means no limit.
+    double time_budget_ms = 0;
+};
+
+struct ExactResult {
+    // Optimum when `optimal`, otherwise the best upper bound known (greedy).
+    int flips = 0;
+    // Proven lower bound; equals `flips` when `optimal`.
+    int lower_bound = 0;
+    bool optimal = false;
+    // Search nodes expanded.
+    uint64_t nodes = 0;
+    // A plan of `flips` rectangles: the optimal one, or the greedy plan.
+    vector<Rect> rects;
+};
+
+// Non-owning row-major byte matrix; any nonzero byte is a one. Row r
+// starts at data + r * stride.
+struct ByteMatrixView {
+    int rows = 0;
+    int cols = 0;
+    size_t stride = 0;              // bytes per row, at least cols
+    const uint8_t* data = nullptr;
+};
+
+// Non-owning bit matrix: bit c of row r is bit c % 64 of
+// words[r * stride + c / 64]. Bits past cols are ignored.
+struct PackedMatrixView {
+    int rows = 0;
+    int cols = 0;
+    size_t stride = 0;              // words per row, at least ceil(cols / 64)
+    const uint64_t* words = nullptr;
+};
+
+// Every solve() reads its input in place and packs it once into the bit
+// matrix the greedy works on. Views throw std::invalid_argument on negative
+// dimensions, a stride shorter than a row, or null data.
+int solve(int m, int n, const vector<vector<bool>>& matrix);
+int solve(int m, int n, const vector<vector<bool>>& matrix, const SolveOptions& options);
+int solve(const ByteMatrixView& view, const SolveOptions& options = SolveOptions());
+int solve(const PackedMatrixView& view, const SolveOptions& options = SolveOptions());
+
+// Like solve() on a packed matrix, but the greedy works directly on the
+// caller's words, so nothing proportional to the matrix is copied. Consumes
+// the buffer: every bit of the rows x cols matrix, and every padding bit
+// of its rows, is zero on return.
+int solve_in_place(int rows, int cols, uint64_t* words, size_t stride,
+                   const SolveOptions& options = SolveOptions());
+
+// Like solve(), but also return the rectangles in the order they were
+// flipped. The overload taking a Plan reuses its capacity, so passing the
+// same Plan again stops allocating once it holds the longest plan so far.
+Plan solve_with_plan(int m, int n, const vector<vector<bool>>& matrix,
+                     const SolveOptions& options = SolveOptions());
+void solve_with_plan(int m, int n, const vector<vector<bool>>& matrix,
+                     const SolveOptions& options, Plan& plan);
+
+// A flip toggles exactly four cells of the matrix's 2D XOR-difference
+// (corner) grid, so no plan is shorter than ceil(odd corners / 4). O(mn)
+// with word-wide XORs; throws std::invalid_argument like solve().
+int corner_lower_bound(int m, int n, const vector<vector<bool>>& matrix);
+
+// True when flipping every rectangle of plan clears matrix. Replays the
+// plan on a packed copy with word-level XOR; out-of-range rectangles fail.
+bool verify_plan(int m, int n, const vector<vector<bool>>& matrix,
+                 const vector<Rect>& plan);
+
+struct AnytimeOptions {
+    // Options of the initial greedy run.
+    SolveOptions greedy;
+    // Wall-clock budget of the whole call, greedy run included. The greedy
+    // plan is always produced, even when it alone overruns the budget.
+    double deadline_ms = 0;
+    // Seed of the local search.
+    uint32_t seed = 1;
+    // Called with the greedy plan as soon as it exists and again after
+    // every improvement, so callers can stop waiting at any point.
+    function<void(const Plan&)> on_improve;
+};
+
+// Greedy plan improved by local search until the deadline: pairs of
+// rectangles whose XOR is one rectangle are merged, and small groups of
+// nearby rectangles are replaced by an exact cover of their XOR. Every
+// intermediate plan is valid; the returned plan is the best one found.
+// Returns early when a plan reaches corner_lower_bound().
+Plan solve_anytime(int m, int n, const vector<vector<bool>>& matrix,
+                  const AnytimeOptions& options);
+
+// Coordinates of one set cell.
+struct Cell {
+    int r, c;
+};
+
+struct SparseOptions {
+    // Largest height and width of a candidate rectangle.
+    int reach = 16;
+};
+
+// Greedy for matrices given as the list of their set cells (duplicates
+// count once). Candidates are the rectangles whose top-left and
+// bottom-right cells are set and whose sides are at most options.reach,
+// scored by net gain (see Scoring); ties go to the first anchor in
+// row-major order. Memory is O(m + ones) and a flip only re-scores the
+// anchors within reach of it, so the time depends on the ones and their
+// neighbourhoods, not on m * n. Throws std::invalid_argument for cells
+// outside the matrix.
+Plan solve_sparse(int m, int n, const vector<Cell>& ones,
+                  const SparseOptions& options = SparseOptions());
+
+struct IncrementalOptions {
+    // Options of every full greedy run (construction and rebuild()).
+    SolveOptions greedy;
+    // Side of the square window re-solved around a toggled cell; at most 8
+    // so the window fits solve_exact().
+    int window = 8;
+    // Node budget of each window's exact search.
+    uint64_t window_nodes = 20000;
+    // rebuild() runs on its own once the plan exceeds max_drift times the
+    // flips greedy would be expected to need: the current corner lower
+    // bound scaled by the flips-to-bound ratio of the last rebuild. 0 turns
+    // automatic rebuilds off.
+    double max_drift = 1.5;
+};
+
+// Matrix plus a plan that clears it, kept valid across single-cell
+// updates. toggle() repairs the plan inside a small window around the cell
+// instead of solving the whole matrix again: the plan's rectangles inside
+// that window and the toggled cell are replaced by an exact cover of their
+// XOR when that is shorter than appending a 1x1 flip. The corner lower
+// bound is maintained in O(1) per toggle and drives the drift check.
+class IncrementalSolver {
+public:
+    // Throws std::invalid_argument like solve(), or for a window outside 1..8.
+    IncrementalSolver(int m, int n, const vector<vector<bool>>& matrix,
+                      const IncrementalOptions& options = IncrementalOptions());
+    ~IncrementalSolver();
+    IncrementalSolver(IncrementalSolver&&) noexcept;
+    IncrementalSolver& operator=(IncrementalSolver&&) noexcept;
+
+    // Flip cell (r, c) of the matrix and repair the plan. Throws
+    // std::out_of_range outside the matrix.
+    void toggle(int r, int c);
+    // Replace the plan by a fresh greedy plan of the current matrix.
+    void rebuild();
+
+    // Cell (r, c) of the current matrix. Throws std::out_of_range outside
+    // the matrix.
+    bool get(int r, int c) const;
+    const Plan& plan() const;
+    // corner_lower_bound() of the current matrix.
+    int lower_bound() const;
+    // Rebuilds so far, automatic ones included; construction is not one.
+    uint64_t rebuilds() const;
+
+private:
+    struct State;
+    unique_ptr<State> state_;
+};
+
+// Bounded LRU cache of greedy plans, safe to share between threads. A
+// matrix is keyed by its canonical form: the smallest packed image over
+// its 8 rotations and mirror images. Hits return the cached plan mapped
+// back onto the given orientation. Misses solve the canonical form, so
+// every orientation gets the same flip count, which can differ from what
+// solve() returns for that orientation directly.
+class SolveCache {
+public:
+    // Keeps at most `capacity` plans; 0 disables caching. options is used
+    // for every solve, except options.stats: the cache does not fill stats.
+    explicit SolveCache(size_t capacity, const SolveOptions& options = SolveOptions());
+    ~SolveCache();
+    SolveCache(const SolveCache&) = delete;
+    SolveCache& operator=(const SolveCache&) = delete;
+
+    // Throws std::invalid_argument like solve().
+    Plan solve(int m, int n, const vector<vector<bool>>& matrix);
+
+    uint64_t hits() const;
+    uint64_t misses() const;
+    size_t size() const;
+    void clear();
+
+private:
+    struct State;
+    unique_ptr<State> state_;
+};
+
+// Long-lived solver for a stream of matrices. It keeps its working
+// buffers, and its scan pool, between calls, so after the largest matrix
+// has been seen no call allocates. Not safe to share between threads;
+// use one per thread.
+class Solver {
+public:
+    explicit Solver(const SolveOptions& options = SolveOptions());
+    ~Solver();
+    Solver(Solver&&) noexcept;
+    Solver& operator=(Solver&&) noexcept;
+
+    // Same results and errors as the free solve() overloads.
+    int solve(int m, int n, const vector<vector<bool>>& matrix);
+    int solve(const ByteMatrixView& view);
+    int solve(const PackedMatrixView& view);
+    // Like solve_with_plan(); plan.rects keeps its capacity too.
+    void solve_with_plan(int m, int n, const vector<vector<bool>>& matrix, Plan& plan);
+
+    // Bytes currently allocated for working buffers.
+    size_t scratch_bytes() const;
+    // Free the working buffers; the next call allocates them again.
+    void release();
+
+private:
+    struct State;
+    unique_ptr<State> state_;
+};
+
+// Solve every matrix (dimensions taken from the vectors) on a pool of
+// options.threads workers, each reusing its scratch buffers between jobs.
+// Results are in input order. The first invalid matrix in input order is
+// rethrown after the batch finishes. options.stats, if set, receives the
+// sum over all matrices, with best_cover concatenated in input order.
+vector<int> solve_batch(const vector<vector<vector<bool>>>& matrices,
+                        const SolveOptions& options = SolveOptions());
+
+// Branch-and-bound optimum for matrices with m * n <= 64, seeded with the
+// greedy result and pruned with the corner-parity lower bound.
+ExactResult solve_exact(int m, int n, const vector<vector<bool>>& matrix,
+                        const ExactOptions& options = ExactOptions());
 }
-#endif
\ No newline at end of file
+#endif
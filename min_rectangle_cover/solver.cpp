@@ -0,0 +1,110 @@
+#include "solution.h"
+#include "greedy.h"
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+namespace solution {
+    namespace {
+        template <typename T>
+        size_t capacity_bytes(const vector<T>& v) {
+            return v.capacity() * sizeof(T);
+        }
+
+        size_t scratch_bytes(const Scratch& s) {
+            size_t total = s.bits.capacity_bytes() + s.corners.capacity_bytes() +
+                           s.reduced.capacity_bytes();
+            total += capacity_bytes(s.pref) + capacity_bytes(s.acc) +
+                     capacity_bytes(s.heights) + capacity_bytes(s.stack) +
+                     capacity_bytes(s.per_row) + capacity_bytes(s.heap) +
+                     capacity_bytes(s.anchor_best) + capacity_bytes(s.anchor_version) +
+                     capacity_bytes(s.anchor_fresh) + capacity_bytes(s.row_start) +
+                     capacity_bytes(s.col_start) + capacity_bytes(s.col_changes) +
+                     capacity_bytes(s.lifted) + capacity_bytes(s.block_ones);
+            if (s.coarse) total += sizeof(Scratch) + scratch_bytes(*s.coarse);
+            return total;
+        }
+    }
+
+    struct Solver::State {
+        SolveOptions options;
+        Scratch scratch;
+        unique_ptr<ThreadPool> pool;
+
+        // Greedy on the loaded or attached scratch.bits.
+        int run(vector<Rect>* plan) {
+            return solve_packed(scratch, options, pool.get(), plan);
+        }
+    };
+
+    Solver::Solver(const SolveOptions& options)
+        : state_(new State{options, {}, nullptr}) {
+        if (options.threads != 1 && options.strategy == Strategy::EXHAUSTIVE) {
+            state_->pool.reset(new ThreadPool(options.threads));
+            if (state_->pool->size() == 1) state_->pool.reset();
+        }
+    }
+
+    Solver::~Solver() = default;
+    Solver::Solver(Solver&&) noexcept = default;
+    Solver& Solver::operator=(Solver&&) noexcept = default;
+
+    int Solver::solve(int m, int n, const vector<vector<bool>>& matrix) {
+        if (m == 0 || n == 0) {
+            reset_stats(state_->options);
+            return 0;
+        }
+
+        load_matrix(m, n, matrix, state_->scratch.bits);
+        return state_->run(nullptr);
+    }
+
+    int Solver::solve(const ByteMatrixView& view) {
+        check_view(view.rows, view.cols, view.stride, static_cast<size_t>(view.cols), view.data);
+        if (view.rows == 0 || view.cols == 0) {
+            reset_stats(state_->options);
+            return 0;
+        }
+
+        state_->scratch.bits.load_bytes(view.data, view.rows, view.cols, view.stride);
+        return state_->run(nullptr);
+    }
+
+    int Solver::solve(const PackedMatrixView& view) {
+        size_t words = (static_cast<size_t>(view.cols) + BitMatrix::WORD_BITS - 1) /
+                       BitMatrix::WORD_BITS;
+        check_view(view.rows, view.cols, view.stride, words, view.words);
+        if (view.rows == 0 || view.cols == 0) {
+            reset_stats(state_->options);
+            return 0;
+        }
+
+        state_->scratch.bits.load(view.words, view.rows, view.cols, view.stride);
+        return state_->run(nullptr);
+    }
+
+    void Solver::solve_with_plan(int m, int n, const vector<vector<bool>>& matrix, Plan& plan) {
+        plan.flips = 0;
+        plan.rects.clear();
+        if (m == 0 || n == 0) {
+            reset_stats(state_->options);
+            return;
+        }
+
+        BitMatrix& bits = state_->scratch.bits;
+        load_matrix(m, n, matrix, bits);
+        // A first guess, as in the free solve_with_plan(); plan.rects keeps
+        // whatever it grew to on earlier calls.
+        plan.rects.reserve(bits.count());
+        plan.flips = state_->run(&plan.rects);
+    }
+
+    size_t Solver::scratch_bytes() const {
+        return solution::scratch_bytes(state_->scratch);
+    }
+
+    void Solver::release() {
+        state_->scratch = Scratch();
+    }
+}
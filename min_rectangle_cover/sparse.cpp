@@ -0,0 +1,169 @@
+#include "solution.h"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace solution {
+    // Greedy over a coordinate list. Each row keeps its set columns sorted,
+    // so the ones inside a rectangle are counted with two binary searches
+    // per row and nothing is ever sized by m * n. A rectangle is a
+    // candidate when its top-left and bottom-right cells are set and it is
+    // at most `reach` cells high and wide; it scores its net gain.
+    namespace {
+        struct Entry {
+            int net;
+            int r, c;
+            uint32_t version;
+            Rect rect;
+        };
+
+        // Larger net gain first, then the anchor a row-major scan meets first.
+        bool entry_lower(const Entry& a, const Entry& b) {
+            if (a.net != b.net) return a.net < b.net;
+            if (a.r != b.r) return a.r > b.r;
+            return a.c > b.c;
+        }
+
+        struct SparseGreedy {
+            int m, n, reach;
+            vector<vector<int>> rows;               // set columns, sorted
+            size_t ones = 0;
+            vector<Entry> heap;
+            unordered_map<uint64_t, uint32_t> version;
+
+            uint64_t key(int r, int c) const { return static_cast<uint64_t>(r) * n + c; }
+
+            bool is_set(int r, int c) const {
+                return binary_search(rows[r].begin(), rows[r].end(), c);
+            }
+
+            int count_in_row(int r, int c1, int c2) const {
+                const vector<int>& cols = rows[r];
+                return static_cast<int>(upper_bound(cols.begin(), cols.end(), c2) -
+                                        lower_bound(cols.begin(), cols.end(), c1));
+            }
+
+            // Best candidate anchored at the set cell (r1, c1), scanned in
+            // (r2, c2) order so the first strictly larger net gain wins.
+            Entry best_at(int r1, int c1) const {
+                Entry best{1, r1, c1, 0, Rect{r1, c1, r1, c1}};
+                int last_row = min(m - 1, r1 + reach - 1);
+                int last_col = min(n - 1, c1 + reach - 1);
+                for (int r2 = r1; r2 <= last_row; ++r2) {
+                    const vector<int>& cols = rows[r2];
+                    auto it = lower_bound(cols.begin(), cols.end(), c1);
+                    for (; it != cols.end() && *it <= last_col; ++it) {
+                        int c2 = *it;
+                        int inside = 0;
+                        for (int r = r1; r <= r2; ++r) inside += count_in_row(r, c1, c2);
+                        int net = 2 * inside - (r2 - r1 + 1) * (c2 - c1 + 1);
+                        if (net > best.net) {
+                            best.net = net;
+                            best.rect = {r1, c1, r2, c2};
+                        }
+                    }
+                }
+                return best;
+            }
+
+            void push(int r, int c) {
+                Entry e = best_at(r, c);
+                e.version = ++version[key(r, c)];
+                heap.push_back(e);
+                push_heap(heap.begin(), heap.end(), entry_lower);
+            }
+
+            // Toggle columns c1..c2 of row r, keeping the row sorted.
+            void toggle(int r, int c1, int c2) {
+                vector<int>& cols = rows[r];
+                auto lo = lower_bound(cols.begin(), cols.end(), c1);
+                auto hi = upper_bound(lo, cols.end(), c2);
+                vector<int> inside;
+                inside.reserve(static_cast<size_t>(c2 - c1 + 1) - (hi - lo));
+                auto it = lo;
+                for (int c = c1; c <= c2; ++c) {
+                    if (it != hi && *it == c) ++it;
+                    else inside.push_back(c);
+                }
+                ones += inside.size();
+                ones -= hi - lo;
+                size_t at = lo - cols.begin();
+                cols.erase(lo, hi);
+                cols.insert(cols.begin() + at, inside.begin(), inside.end());
+            }
+
+            // Flip rect and re-key every set anchor whose candidates can
+            // overlap it: those up to reach - 1 cells above and left of it.
+            void flip(const Rect& rect) {
+                for (int r = rect.r1; r <= rect.r2; ++r) toggle(r, rect.c1, rect.c2);
+                int r_first = max(0, rect.r1 - reach + 1);
+                int c_first = max(0, rect.c1 - reach + 1);
+                for (int r = r_first; r <= rect.r2; ++r) {
+                    const vector<int>& cols = rows[r];
+                    auto it = lower_bound(cols.begin(), cols.end(), c_first);
+                    for (; it != cols.end() && *it <= rect.c2; ++it) push(r, *it);
+                }
+
+                // Drop dead entries once they outnumber the set cells.
+                if (heap.size() > 2 * ones + 1024) {
+                    heap.erase(remove_if(heap.begin(), heap.end(), [&](const Entry& e) {
+                        return !live(e);
+                    }), heap.end());
+                    make_heap(heap.begin(), heap.end(), entry_lower);
+                }
+            }
+
+            bool live(const Entry& e) const {
+                auto it = version.find(key(e.r, e.c));
+                return it != version.end() && it->second == e.version && is_set(e.r, e.c);
+            }
+
+            Rect pop_best() {
+                while (!live(heap.front())) {
+                    pop_heap(heap.begin(), heap.end(), entry_lower);
+                    heap.pop_back();
+                }
+                return heap.front().rect;
+            }
+        };
+    }
+
+    Plan solve_sparse(int m, int n, const vector<Cell>& ones, const SparseOptions& options){
+        if (m < 0 || n < 0) {
+            throw std::invalid_argument("m < 0 or n < 0");
+        }
+        if (options.reach < 1) {
+            throw std::invalid_argument("reach < 1");
+        }
+        SparseGreedy greedy{m, n, options.reach, vector<vector<int>>(m), 0, {}, {}};
+        for (const Cell& cell : ones) {
+            if (cell.r < 0 || cell.r >= m || cell.c < 0 || cell.c >= n) {
+                throw std::invalid_argument("cell outside the matrix");
+            }
+            greedy.rows[cell.r].push_back(cell.c);
+        }
+        for (vector<int>& cols : greedy.rows) {
+            sort(cols.begin(), cols.end());
+            cols.erase(unique(cols.begin(), cols.end()), cols.end());
+            greedy.ones += cols.size();
+        }
+
+        greedy.heap.reserve(greedy.ones);
+        greedy.version.reserve(greedy.ones);
+        for (int r = 0; r < m; ++r) {
+            for (int c : greedy.rows[r]) greedy.push(r, c);
+        }
+
+        Plan plan;
+        while (greedy.ones > 0) {
+            Rect rect = greedy.pop_best();
+            greedy.flip(rect);
+            plan.rects.push_back(rect);
+        }
+        plan.flips = static_cast<int>(plan.rects.size());
+        return plan;
+    }
+}
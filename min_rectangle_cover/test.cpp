@@ -1,13 +1,80 @@
 #include <iostream>
 #include <vector>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
 #include <random>
 #include <unordered_set>
 #include "solution.h"
 #include "harmonic.h"
+#include "matrix_file.h"
+#include "small_solver.h"
+#include "greedy.h"
 
 using namespace solution;
 
+// Every operator new call of the process, for the allocation checks.
+// All replaceable forms are defined so allocation and deallocation
+// always pair malloc with free, also under AddressSanitizer.
+static std::atomic<uint64_t> allocations{0};
+
+static void* allocate(std::size_t size, std::size_t align) noexcept {
+    ++allocations;
+    if (align <= alignof(std::max_align_t)) return std::malloc(size ? size : 1);
+    return std::aligned_alloc(align, (size + align - 1) / align * align + (size ? 0 : align));
+}
+
+static void* allocate_or_throw(std::size_t size, std::size_t align) {
+    if (void* p = allocate(size, align)) return p;
+    throw std::bad_alloc();
+}
+
+// Out of line so GCC does not pair an inlined free() with a new
+// expression and warn about a mismatch.
+[[gnu::noinline]] static void release(void* p) noexcept { std::free(p); }
+
+void* operator new(std::size_t size) {
+    return allocate_or_throw(size, 0);
+}
+void* operator new[](std::size_t size) {
+    return allocate_or_throw(size, 0);
+}
+void* operator new(std::size_t size, std::align_val_t align) {
+    return allocate_or_throw(size, static_cast<std::size_t>(align));
+}
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return allocate_or_throw(size, static_cast<std::size_t>(align));
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, 0);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, 0);
+}
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<std::size_t>(align));
+}
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, std::size_t) noexcept { release(p); }
+void operator delete[](void* p, std::size_t) noexcept { release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { release(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { release(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { release(p); }
+
 #define CHECK_GREEDY(i,m,n,mat,opt)                                   \
     do {                                                              \
         int res = solve(m, n, mat);                                   \
@@ -314,6 +381,849 @@ void test_empty_vector_positive_dims() {
     cout << "Test 26: Empty vector with positive dimensions passed." << endl;
 }
 
+void test_block_across_word_boundary() {
+    int m = 3, n = 130;
+    std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n, false));
+    for (int i = 1; i < 3; ++i) {
+        for (int j = 60; j < 70; ++j) matrix[i][j] = true;
+    }
+    CHECK_GREEDY(27, m, n, matrix, /*OPT=*/1);
+}
+
+void test_parallel_matches_serial() {
+    std::mt19937 rng(7);
+    SolveOptions parallel;
+    parallel.threads = 4;
+    // At least PARALLEL_MIN_ROWS rows, so the scan is split over the pool.
+    for (int t = 0; t < 20; ++t) {
+        int m = 16 + rng() % 33, n = 1 + rng() % 16;
+        std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n));
+        for (auto& row : matrix) {
+            for (size_t j = 0; j < row.size(); ++j) row[j] = rng() % 2;
+        }
+        Plan threaded = solve_with_plan(m, n, matrix, parallel);
+        Plan serial = solve_with_plan(m, n, matrix, SolveOptions());
+        assert(threaded.flips == serial.flips);
+        assert(threaded.rects.size() == serial.rects.size());
+        for (size_t k = 0; k < serial.rects.size(); ++k) {
+            const Rect& a = threaded.rects[k];
+            const Rect& b = serial.rects[k];
+            assert(a.r1 == b.r1 && a.c1 == b.c1 && a.r2 == b.r2 && a.c2 == b.c2);
+        }
+        assert(solve(m, n, matrix, parallel) == serial.flips);
+    }
+    cout << "Test 28: Parallel scan matches serial passed." << endl;
+}
+
+void test_maximal_strategy() {
+    SolveOptions maximal;
+    maximal.strategy = Strategy::MAXIMAL;
+    std::vector<std::vector<bool>> block = {
+        {0, 0, 0, 0},
+        {0, 1, 1, 0},
+        {0, 1, 1, 0}
+    };
+    assert(solve(3, 4, block, maximal) == 1);
+    std::vector<std::vector<bool>> checkerboard = {
+        {1, 0, 1, 0},
+        {0, 1, 0, 1},
+        {1, 0, 1, 0},
+        {0, 1, 0, 1}
+    };
+    assert(solve(4, 4, checkerboard, maximal) == 8);
+    std::vector<std::vector<bool>> notch = {
+        {1, 1, 0},
+        {1, 1, 1},
+        {1, 1, 1},
+        {1, 1, 1},
+    };
+    assert(solve(4, 3, notch, maximal) == 2);
+    cout << "Test 29: Maximal strategy passed." << endl;
+}
+
+void test_exact_small() {
+    std::vector<std::vector<bool>> cross = {
+        {0, 1, 0},
+        {1, 1, 1},
+        {0, 1, 0}
+    };
+    ExactResult res = solve_exact(3, 3, cross);
+    assert(res.optimal && res.flips == 3);
+
+    std::vector<std::vector<bool>> blocks = {
+        {1, 1, 0, 0, 0, 0},
+        {1, 1, 0, 0, 0, 0},
+        {0, 0, 1, 1, 1, 0},
+        {0, 0, 1, 1, 1, 0},
+        {1, 1, 0, 0, 0, 0},
+        {1, 1, 0, 0, 0, 0},
+        {1, 1, 0, 0, 0, 0}
+    };
+    res = solve_exact(7, 6, blocks);
+    assert(res.optimal && res.flips == 2);
+
+    std::vector<std::vector<bool>> mixed = {
+        {1, 0, 0, 0, 0, 0},
+        {1, 0, 0, 0, 0, 0},
+        {0, 1, 0, 0, 0, 0},
+        {0, 1, 0, 0, 0, 0},
+        {0, 1, 1, 0, 0, 1},
+        {0, 1, 0, 1, 1, 0},
+        {1, 0, 1, 0, 0, 1},
+        {1, 0, 1, 0, 0, 1}
+    };
+    res = solve_exact(8, 6, mixed);
+    assert(res.optimal && res.flips == 5 && res.nodes > 0);
+    assert(res.rects.size() == 5 && verify_plan(8, 6, mixed, res.rects));
+
+    ExactOptions tiny;
+    tiny.node_budget = 1;
+    res = solve_exact(8, 6, mixed, tiny);
+    assert(!res.optimal && res.lower_bound <= 5 && res.flips >= 5);
+    cout << "Test 30: Exact solver passed." << endl;
+}
+
+void test_batch_in_order() {
+    std::mt19937 rng(11);
+    std::vector<std::vector<std::vector<bool>>> matrices;
+    for (int t = 0; t < 40; ++t) {
+        int m = 1 + rng() % 9, n = 1 + rng() % 9;
+        std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n));
+        for (auto& row : matrix) {
+            for (size_t j = 0; j < row.size(); ++j) row[j] = rng() % 3 == 0;
+        }
+        matrices.push_back(matrix);
+    }
+    matrices.push_back({});
+    SolveOptions options;
+    options.threads = 3;
+    std::vector<int> results = solve_batch(matrices, options);
+    assert(results.size() == matrices.size());
+    for (size_t i = 0; i < matrices.size(); ++i) {
+        int m = matrices[i].size();
+        int n = m ? matrices[i][0].size() : 0;
+        assert(results[i] == solve(m, n, matrices[i]));
+    }
+
+    matrices.push_back({{1, 0}, {1}});
+    bool threw = false;
+    try {
+        solve_batch(matrices, options);
+    } catch (const std::exception& e) {
+        threw = true;
+    }
+    assert(threw);
+    cout << "Test 31: Batch solve passed." << endl;
+}
+
+void test_matrix_file_round_trip() {
+    std::vector<std::vector<std::vector<bool>>> matrices = {
+        {{1, 0, 1}, {0, 1, 0}},
+        {},
+        std::vector<std::vector<bool>>(3, std::vector<bool>(70, true))
+    };
+    matrices[2][1][65] = false;
+    const char* path = "matrix_file_test.bin";
+    write_matrix_file(path, matrices);
+    {
+        MatrixFile file(path);
+        assert(file.size() == matrices.size());
+        for (size_t k = 0; k < matrices.size(); ++k) {
+            PackedMatrixView view = file.view(k);
+            assert(view.rows == (int)matrices[k].size());
+            assert(reinterpret_cast<uintptr_t>(view.words) % 8 == 0);
+            for (int i = 0; i < view.rows; ++i) {
+                for (int j = 0; j < view.cols; ++j) {
+                    bool bit = (view.words[i * view.stride + j / 64] >> (j % 64)) & 1;
+                    assert(bit == matrices[k][i][j]);
+                }
+            }
+        }
+    }
+    std::remove(path);
+    cout << "Test 32: Matrix file round trip passed." << endl;
+}
+
+void test_stats() {
+    std::vector<std::vector<bool>> matrix = {
+        {1, 1, 0},
+        {1, 1, 1},
+        {1, 1, 1},
+        {1, 1, 1},
+    };
+    SolveStats stats;
+    SolveOptions options;
+    options.stats = &stats;
+    int res = solve(4, 3, matrix, options);
+    if (STATS_ENABLED) {
+        assert(stats.iterations == (uint64_t)res);
+        assert(stats.best_cover.size() == stats.iterations);
+        assert(stats.best_cover[0] == 11);
+        // 60 rectangles in a 4x3 grid and the anchor (0, 2) owns 4 of them;
+        // it is the only zero anchor first and the only set one after.
+        assert(res == 2);
+        assert(stats.candidates_scanned == 56 + 4);
+        assert(stats.candidates_skipped == 4 + 56);
+
+        // Inputs that return before the greedy still reset the counters.
+        std::vector<std::vector<bool>> zeros(4, std::vector<bool>(3, false));
+        assert(solve(4, 3, zeros, options) == 0);
+        assert(stats.iterations == 0 && stats.best_cover.empty());
+        stats.iterations = 5;
+        assert(solve_with_plan(4, 3, zeros, options).flips == 0);
+        assert(stats.iterations == 0);
+        stats.iterations = 5;
+        assert(solve(0, 3, {}, options) == 0);
+        assert(stats.iterations == 0);
+    } else {
+        assert(stats.iterations == 0 && stats.best_cover.empty());
+    }
+    cout << "Test 33: Solver stats passed." << endl;
+}
+
+void test_plan_replays() {
+    std::mt19937 rng(5);
+    Plan plan;
+    for (int t = 0; t < 30; ++t) {
+        int m = 1 + rng() % 9, n = 1 + rng() % 9;
+        std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n));
+        for (auto& row : matrix) {
+            for (size_t j = 0; j < row.size(); ++j) row[j] = rng() % 2;
+        }
+        SolveOptions options;
+        options.strategy = t % 2 ? Strategy::MAXIMAL : Strategy::EXHAUSTIVE;
+        solve_with_plan(m, n, matrix, options, plan);
+        assert(plan.flips == (int)plan.rects.size());
+        assert(plan.flips == solve(m, n, matrix, options));
+        assert(verify_plan(m, n, matrix, plan.rects));
+        if (!plan.rects.empty()) {
+            std::vector<Rect> broken(plan.rects.begin() + 1, plan.rects.end());
+            assert(!verify_plan(m, n, matrix, broken));
+        }
+    }
+    // Sparse enough that the greedy flips more rectangles than there are
+    // set cells, so the plan outgrows its initial reservation.
+    std::vector<std::vector<bool>> sparse = {
+        {0, 0, 1, 1, 0},
+        {0, 1, 0, 1, 1},
+        {0, 0, 0, 0, 0},
+        {1, 1, 0, 0, 0},
+        {0, 0, 0, 0, 1}
+    };
+    solve_with_plan(5, 5, sparse, SolveOptions(), plan);
+    assert(plan.flips == 10 && plan.flips == (int)plan.rects.size());
+    assert(verify_plan(5, 5, sparse, plan.rects));
+    Solver solver;
+    Plan fresh;
+    solver.solve_with_plan(5, 5, sparse, fresh);
+    assert(fresh.flips == 10 && verify_plan(5, 5, sparse, fresh.rects));
+
+    std::vector<std::vector<bool>> one = {{1}};
+    assert(!verify_plan(1, 1, one, {Rect{0, 0, 1, 0}}));
+    cout << "Test 34: Plan replay passed." << endl;
+}
+
+void test_lazy_matches_exhaustive() {
+    std::mt19937 rng(13);
+    SolveOptions lazy;
+    lazy.strategy = Strategy::LAZY;
+    for (int t = 0; t < 40; ++t) {
+        int m = 1 + rng() % 12, n = 1 + rng() % 12;
+        std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n));
+        for (auto& row : matrix) {
+            for (size_t j = 0; j < row.size(); ++j) row[j] = rng() % 4 != 0;
+        }
+        Plan expected = solve_with_plan(m, n, matrix);
+        Plan actual = solve_with_plan(m, n, matrix, lazy);
+        assert(actual.flips == expected.flips);
+        for (int k = 0; k < actual.flips; ++k) {
+            const Rect& a = actual.rects[k];
+            const Rect& b = expected.rects[k];
+            assert(a.r1 == b.r1 && a.c1 == b.c1 && a.r2 == b.r2 && a.c2 == b.c2);
+        }
+    }
+    cout << "Test 35: Lazy strategy matches exhaustive passed." << endl;
+}
+
+void test_small_specialization() {
+    // {1,1,0},{1,1,1},{1,1,1},{1,1,1} packed as bit r * 3 + c.
+    uint64_t notch = 0xFFB;
+    std::vector<Rect> plan;
+    assert((solve<4, 3>(notch, &plan) == 2));
+    assert(plan.size() == 2);
+    assert(plan[0].r1 == 0 && plan[0].c1 == 0 && plan[0].r2 == 3 && plan[0].c2 == 2);
+    assert(solve_small(4, 3, notch) == 2);
+    assert((solve<8, 8>(0) == 0));
+    assert((solve<8, 8>(~uint64_t(0)) == 1));
+    assert((solve<1, 8>(0x55) == 4));
+    cout << "Test 36: Small fixed-size solver passed." << endl;
+}
+
+void test_anytime_improves() {
+    std::mt19937 rng(17);
+    int m = 24, n = 24;
+    std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n));
+    for (auto& row : matrix) {
+        for (size_t j = 0; j < row.size(); ++j) row[j] = rng() % 2;
+    }
+    int greedy = solve(m, n, matrix);
+    int reported = 0;
+    AnytimeOptions options;
+    options.deadline_ms = 200;
+    options.on_improve = [&](const Plan& plan) {
+        assert(reported == 0 || plan.flips < reported);
+        reported = plan.flips;
+    };
+    Plan plan = solve_anytime(m, n, matrix, options);
+    assert(plan.flips == (int)plan.rects.size());
+    assert(plan.flips == reported);
+    // How far the search gets depends on the machine, so only check that
+    // it never makes the greedy plan worse.
+    assert(plan.flips <= greedy);
+    assert(verify_plan(m, n, matrix, plan.rects));
+
+    // Greedy takes the whole 2x2 and then fixes two cells; the search
+    // finds the two-flip cover, which meets the lower bound and ends the
+    // call long before the deadline.
+    std::vector<std::vector<bool>> diagonal = {{1, 0}, {0, 1}};
+    AnytimeOptions generous;
+    generous.deadline_ms = 60000;
+    Plan improved = solve_anytime(2, 2, diagonal, generous);
+    assert(solve(2, 2, diagonal) == 3);
+    assert(improved.flips == 2);
+    assert(verify_plan(2, 2, diagonal, improved.rects));
+    cout << "Test 37: Anytime local search passed (" << greedy << " -> "
+         << plan.flips << ")." << endl;
+}
+
+void test_net_gain_scoring() {
+    // The whole 2x2 covers both ones but creates two; net gain flips the
+    // two diagonal cells instead.
+    std::vector<std::vector<bool>> diagonal = {{1, 0}, {0, 1}};
+    SolveOptions net;
+    net.scoring = Scoring::NET_GAIN;
+    assert(solve(2, 2, diagonal) == 3);
+    assert(solve(2, 2, diagonal, net) == 2);
+
+    std::mt19937 rng(19);
+    SolveOptions lazy = net;
+    lazy.strategy = Strategy::LAZY;
+    int cover_flips = 0, net_flips = 0;
+    for (int t = 0; t < 40; ++t) {
+        int m = 1 + rng() % 12, n = 1 + rng() % 12;
+        std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n));
+        for (auto& row : matrix) {
+            for (size_t j = 0; j < row.size(); ++j) row[j] = rng() % 2;
+        }
+        Plan expected = solve_with_plan(m, n, matrix, net);
+        Plan actual = solve_with_plan(m, n, matrix, lazy);
+        assert(verify_plan(m, n, matrix, expected.rects));
+        assert(actual.flips == expected.flips);
+        for (int k = 0; k < actual.flips; ++k) {
+            const Rect& a = actual.rects[k];
+            const Rect& b = expected.rects[k];
+            assert(a.r1 == b.r1 && a.c1 == b.c1 && a.r2 == b.r2 && a.c2 == b.c2);
+        }
+
+        // A zero row and column never raise a net gain, so the padded
+        // matrix (general path) makes the same choices as the small solver.
+        if (m <= 8 && n <= 8) {
+            std::vector<std::vector<bool>> padded(9, std::vector<bool>(9));
+            for (int i = 0; i < m; ++i) {
+                for (int j = 0; j < n; ++j) padded[i][j] = matrix[i][j];
+            }
+            assert(solve(9, 9, padded, net) == expected.flips);
+        }
+        cover_flips += solve(m, n, matrix);
+        net_flips += expected.flips;
+    }
+    assert(net_flips < cover_flips);
+    cout << "Test 38: Net-gain scoring passed (" << cover_flips << " -> "
+         << net_flips << " flips)." << endl;
+}
+
+void test_views_and_in_place() {
+    std::mt19937 rng(23);
+    for (int t = 0; t < 20; ++t) {
+        int m = 1 + rng() % 20, n = 1 + rng() % 150;
+        std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n));
+        for (auto& row : matrix) {
+            for (size_t j = 0; j < row.size(); ++j) row[j] = rng() % 3 == 0;
+        }
+        int expected = solve(m, n, matrix);
+
+        // Byte rows with junk past cols; nonzero bytes other than 1 count.
+        size_t byte_stride = n + 5;
+        std::vector<uint8_t> bytes(m * byte_stride, 0xAB);
+        for (int i = 0; i < m; ++i) {
+            for (int j = 0; j < n; ++j) bytes[i * byte_stride + j] = matrix[i][j] ? 7 : 0;
+        }
+        assert(solve(ByteMatrixView{m, n, byte_stride, bytes.data()}) == expected);
+
+        // Packed rows with a spare word and set padding bits.
+        size_t stride = (n + 63) / 64 + 1;
+        std::vector<uint64_t> words(m * stride, ~uint64_t(0));
+        for (int i = 0; i < m; ++i) {
+            for (int j = 0; j < n; ++j) {
+                if (!matrix[i][j]) words[i * stride + j / 64] &= ~(uint64_t(1) << (j % 64));
+            }
+        }
+        assert(solve(PackedMatrixView{m, n, stride, words.data()}) == expected);
+        assert(solve_in_place(m, n, words.data(), stride) == expected);
+        for (uint64_t w : words) assert(w == 0);
+    }
+
+    assert(solve(ByteMatrixView{0, 4, 0, nullptr}) == 0);
+    uint8_t row[3] = {1, 1, 1};
+    bool threw = false;
+    try { solve(ByteMatrixView{1, 3, 2, row}); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+    cout << "Test 39: Strided views and in-place solve passed." << endl;
+}
+
+void test_corner_strategy() {
+    // One block: four odd corners, one flip.
+    std::vector<std::vector<bool>> block = {{0, 0, 0}, {0, 1, 1}, {0, 1, 1}};
+    assert(corner_lower_bound(3, 3, block) == 1);
+    SolveOptions corner;
+    corner.strategy = Strategy::CORNER;
+    Plan plan = solve_with_plan(3, 3, block, corner);
+    assert(plan.flips == 1);
+    assert(plan.rects[0].r1 == 1 && plan.rects[0].c1 == 1 &&
+           plan.rects[0].r2 == 2 && plan.rects[0].c2 == 2);
+
+    // Checkerboard: every interior corner is odd.
+    std::vector<std::vector<bool>> board(4, std::vector<bool>(4));
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) board[i][j] = (i + j) % 2;
+    }
+    assert(corner_lower_bound(4, 4, board) == 4);
+    assert(corner_lower_bound(0, 0, {}) == 0);
+
+    std::mt19937 rng(29);
+    for (int t = 0; t < 40; ++t) {
+        int m = 1 + rng() % 70, n = 1 + rng() % 130;
+        std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n));
+        for (auto& row : matrix) {
+            for (size_t j = 0; j < row.size(); ++j) row[j] = rng() % 2;
+        }
+        int bound = corner_lower_bound(m, n, matrix);
+        plan = solve_with_plan(m, n, matrix, corner);
+        assert(verify_plan(m, n, matrix, plan.rects));
+        assert(plan.flips >= bound && plan.flips <= 2 * bound);
+        if (m * n <= 64) assert(solve_exact(m, n, matrix).flips >= bound);
+    }
+
+    // Local search stops as soon as it reaches the bound (greedy: 11).
+    std::vector<std::vector<bool>> tight = {
+        {1, 1, 0, 0}, {0, 1, 0, 0}, {1, 0, 1, 0}, {0, 0, 1, 0}, {1, 1, 1, 1}, {0, 1, 0, 1}};
+    assert(corner_lower_bound(6, 4, tight) == 5 && solve(6, 4, tight) > 5);
+    AnytimeOptions anytime;
+    anytime.deadline_ms = 10000;
+    auto start = std::chrono::steady_clock::now();
+    plan = solve_anytime(6, 4, tight, anytime);
+    assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+    assert(plan.flips == 5 && verify_plan(6, 4, tight, plan.rects));
+    cout << "Test 40: Corner strategy and lower bound passed." << endl;
+}
+
+void test_sparse_coordinates() {
+    // A 2x2 block plus a lone cell: one flip each.
+    std::vector<Cell> cells = {{3, 3}, {0, 0}, {0, 1}, {1, 0}, {1, 1}, {0, 0}};
+    Plan plan = solve_sparse(5, 5, cells);
+    assert(plan.flips == 2);
+    assert(plan.rects[0].r1 == 0 && plan.rects[0].c1 == 0 &&
+           plan.rects[0].r2 == 1 && plan.rects[0].c2 == 1);
+    assert(solve_sparse(0, 0, {}).flips == 0);
+    bool threw = false;
+    try { solve_sparse(2, 2, {{2, 0}}); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    std::mt19937 rng(31);
+    for (int t = 0; t < 20; ++t) {
+        int m = 1 + rng() % 200, n = 1 + rng() % 200;
+        std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n));
+        cells.clear();
+        for (int k = 0; k < m * n / 50 + 1; ++k) {
+            int r = rng() % m, c = rng() % n;
+            matrix[r][c] = true;
+            cells.push_back({r, c});
+        }
+        plan = solve_sparse(m, n, cells);
+        assert(plan.flips == (int)plan.rects.size());
+        assert(verify_plan(m, n, matrix, plan.rects));
+        assert(plan.flips >= corner_lower_bound(m, n, matrix));
+    }
+
+    // Only the ones matter, not the matrix size.
+    cells.clear();
+    for (int k = 0; k < 1000; ++k) cells.push_back({(int)(rng() % 100000), (int)(rng() % 100000)});
+    plan = solve_sparse(100000, 100000, cells);
+    assert(plan.flips > 0 && plan.flips <= 1000);
+    cout << "Test 41: Sparse coordinate-list solver passed." << endl;
+}
+
+void test_incremental_toggles() {
+    std::mt19937 rng(37);
+    int m = 40, n = 30;
+    std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n));
+    for (auto& row : matrix) {
+        for (size_t j = 0; j < row.size(); ++j) row[j] = rng() % 2;
+    }
+    IncrementalSolver solver(m, n, matrix);
+    assert(solver.plan().flips == solve(m, n, matrix));
+    assert(solver.lower_bound() == corner_lower_bound(m, n, matrix));
+
+    for (int t = 0; t < 200; ++t) {
+        int r = rng() % m, c = rng() % n;
+        int before = solver.plan().flips;
+        solver.toggle(r, c);
+        matrix[r][c] = !matrix[r][c];
+        assert(solver.get(r, c) == matrix[r][c]);
+        assert(solver.plan().flips == (int)solver.plan().rects.size());
+        assert(solver.plan().flips <= before + 1);
+        assert(verify_plan(m, n, matrix, solver.plan().rects));
+        if (t % 50 == 0) assert(solver.lower_bound() == corner_lower_bound(m, n, matrix));
+    }
+
+    // Toggling a cell back cancels the 1x1 repair.
+    int flips = solver.plan().flips;
+    solver.toggle(0, 0);
+    solver.toggle(0, 0);
+    assert(solver.plan().flips <= flips);
+
+    solver.rebuild();
+    assert(solver.plan().flips == solve(m, n, matrix));
+    assert(solver.rebuilds() >= 1);
+
+    // A tight drift limit forces automatic rebuilds.
+    IncrementalOptions strict;
+    strict.max_drift = 1.0;
+    strict.window = 1;
+    IncrementalSolver eager(m, n, matrix, strict);
+    for (int t = 0; t < 50; ++t) eager.toggle(rng() % m, rng() % n);
+    assert(eager.rebuilds() > 0);
+
+    bool threw = false;
+    try { solver.toggle(m, 0); } catch (const std::out_of_range&) { threw = true; }
+    assert(threw);
+    threw = false;
+    try { solver.get(0, -1); } catch (const std::out_of_range&) { threw = true; }
+    assert(threw);
+    cout << "Test 42: Incremental toggles passed." << endl;
+}
+
+void test_dedup_preprocessing() {
+    // Every cell of a random 5x6 core repeated in a block of random size:
+    // the merged matrix is the core itself.
+    std::mt19937 rng(41);
+    SolveOptions dedup;
+    dedup.dedup = true;
+    for (int t = 0; t < 20; ++t) {
+        int cm = 1 + rng() % 5, cn = 1 + rng() % 6;
+        std::vector<std::vector<bool>> core(cm, std::vector<bool>(cn));
+        for (auto& row : core) {
+            for (size_t j = 0; j < row.size(); ++j) row[j] = rng() % 2;
+        }
+        std::vector<int> row_of, col_of;
+        for (int i = 0; i < cm; ++i) row_of.insert(row_of.end(), 1 + rng() % 30, i);
+        for (int j = 0; j < cn; ++j) col_of.insert(col_of.end(), 1 + rng() % 90, j);
+        int m = row_of.size(), n = col_of.size();
+        std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n));
+        for (int i = 0; i < m; ++i) {
+            for (int j = 0; j < n; ++j) matrix[i][j] = core[row_of[i]][col_of[j]];
+        }
+
+        // Equal neighbours in the core merge too: the greedy runs on the
+        // core with repeated adjacent rows and columns dropped.
+        std::vector<std::vector<bool>> reduced;
+        for (int i = 0; i < cm; ++i) {
+            if (i > 0 && core[i] == core[i - 1]) continue;
+            std::vector<bool> row;
+            for (int j = 0; j < cn; ++j) {
+                bool same = j > 0;
+                for (int k = 0; k < cm && same; ++k) same = core[k][j] == core[k][j - 1];
+                if (!same) row.push_back(core[i][j]);
+            }
+            reduced.push_back(row);
+        }
+
+        Plan plan = solve_with_plan(m, n, matrix, dedup);
+        assert(verify_plan(m, n, matrix, plan.rects));
+        assert(plan.flips == solve(reduced.size(), reduced[0].size(), reduced));
+        assert(solve(m, n, matrix, dedup) == plan.flips);
+
+        std::vector<uint64_t> words(m * ((n + 63) / 64), 0);
+        for (int i = 0; i < m; ++i) {
+            for (int j = 0; j < n; ++j) {
+                if (matrix[i][j]) words[i * ((n + 63) / 64) + j / 64] |= uint64_t(1) << (j % 64);
+            }
+        }
+        assert(solve_in_place(m, n, words.data(), (n + 63) / 64, dedup) == plan.flips);
+        for (uint64_t w : words) assert(w == 0);
+    }
+
+    std::vector<std::vector<bool>> corner = {{1, 1, 0}, {1, 1, 0}, {0, 0, 0}};
+    Plan plan = solve_with_plan(3, 3, corner, dedup);
+    assert(plan.flips == 1);
+    assert(plan.rects[0].r1 == 0 && plan.rects[0].c1 == 0 &&
+           plan.rects[0].r2 == 1 && plan.rects[0].c2 == 1);
+    cout << "Test 43: Row/column dedup passed." << endl;
+}
+
+void test_canonical_cache() {
+    std::mt19937 rng(43);
+    int m = 7, n = 11;
+    std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n));
+    for (auto& row : matrix) {
+        for (size_t j = 0; j < row.size(); ++j) row[j] = rng() % 2;
+    }
+
+    SolveCache cache(2);
+    int flips = -1;
+    for (int t = 0; t < 8; ++t) {
+        // Mirror rows, mirror columns, then transpose, as selected by t.
+        int rows = (t & 4) ? n : m, cols = (t & 4) ? m : n;
+        std::vector<std::vector<bool>> image(rows, std::vector<bool>(cols));
+        for (int i = 0; i < m; ++i) {
+            for (int j = 0; j < n; ++j) {
+                int a = (t & 1) ? m - 1 - i : i, b = (t & 2) ? n - 1 - j : j;
+                if (t & 4) std::swap(a, b);
+                image[a][b] = matrix[i][j];
+            }
+        }
+        Plan plan = cache.solve(rows, cols, image);
+        assert(verify_plan(rows, cols, image, plan.rects));
+        assert(flips < 0 || plan.flips == flips);
+        flips = plan.flips;
+    }
+    assert(cache.misses() == 1 && cache.hits() == 7 && cache.size() == 1);
+
+    // Capacity 2: a third matrix evicts the least recently used one.
+    std::vector<std::vector<bool>> one = {{1}};
+    std::vector<std::vector<bool>> two = {{1, 1}};
+    assert(cache.solve(1, 2, two).flips == 1);
+    assert(cache.solve(2, 1, {{1}, {1}}).flips == 1);
+    assert(cache.hits() == 8 && cache.misses() == 2);
+    assert(cache.solve(1, 1, one).flips == 1);
+    cache.solve(m, n, matrix);
+    assert(cache.misses() == 4 && cache.size() == 2);
+    cache.clear();
+    assert(cache.size() == 0);
+
+    // The cache never writes through options.stats.
+    SolveStats stats;
+    stats.iterations = 7;
+    SolveOptions with_stats;
+    with_stats.stats = &stats;
+    SolveCache tracked(1, with_stats);
+    assert(tracked.solve(m, n, matrix).flips == flips);
+    assert(stats.iterations == 7 && stats.best_cover.empty());
+    cout << "Test 44: Canonical-form cache passed." << endl;
+}
+
+void test_coarse_to_fine() {
+    // XOR of large random rectangles plus light noise.
+    std::mt19937 rng(47);
+    int m = 150, n = 170;
+    std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n));
+    for (int b = 0; b < 12; ++b) {
+        int r1 = rng() % m, r2 = rng() % m, c1 = rng() % n, c2 = rng() % n;
+        if (r1 > r2) std::swap(r1, r2);
+        if (c1 > c2) std::swap(c1, c2);
+        for (int i = r1; i <= r2; ++i) {
+            for (int j = c1; j <= c2; ++j) matrix[i][j] = !matrix[i][j];
+        }
+    }
+    for (int k = 0; k < 60; ++k) matrix[rng() % m][rng() % n].flip();
+
+    for (Strategy strategy : {Strategy::EXHAUSTIVE, Strategy::LAZY, Strategy::MAXIMAL,
+                              Strategy::CORNER}) {
+        for (int block : {2, 7, 32}) {
+            SolveOptions options;
+            options.strategy = strategy;
+            options.scoring = Scoring::NET_GAIN;
+            options.coarse_block = block;
+            if (strategy == Strategy::EXHAUSTIVE && block != 32) continue;
+            Plan plan = solve_with_plan(m, n, matrix, options);
+            assert(verify_plan(m, n, matrix, plan.rects));
+            SolveStats stats;
+            options.stats = &stats;
+            assert(solve(m, n, matrix, options) == plan.flips);
+            // Stats cover the coarse and the fine pass together.
+            if (STATS_ENABLED) {
+                assert(stats.iterations == (uint64_t)plan.flips);
+                if (strategy != Strategy::CORNER) {
+                    assert(stats.best_cover.size() == stats.iterations);
+                }
+            }
+        }
+    }
+
+    // A block covering the whole matrix leaves the flat solver in charge.
+    SolveOptions options;
+    options.coarse_block = 8;
+    std::vector<std::vector<bool>> small = {{1, 0, 1}, {1, 1, 0}};
+    assert(solve(2, 3, small, options) == solve(2, 3, small));
+    cout << "Test 45: Coarse-to-fine solving passed." << endl;
+}
+
+
+void test_row_max_kernels() {
+    // Every kernel the CPU offers agrees with the scalar one, including
+    // which of several equal maxima it reports.
+    std::mt19937 rng(53);
+    RowMaxKernel scalar = row_max_kernel(RowMaxIsa::SCALAR);
+    assert(row_max_kernel() != nullptr);
+    for (RowMaxIsa isa : {RowMaxIsa::BEST, RowMaxIsa::SSE41, RowMaxIsa::AVX2}) {
+        RowMaxKernel kernel = row_max_kernel(isa);
+        if (kernel == nullptr) continue;
+        for (int trial = 0; trial < 2000; ++trial) {
+            int width = 1 + rng() % 40;
+            std::vector<int> top(width), bottom(width);
+            for (int k = 0; k < width; ++k) {
+                top[k] = rng() % 3;
+                bottom[k] = top[k] + rng() % 4;
+            }
+            int begin = rng() % width;
+            int mul = 1 + rng() % 2;
+            int slope = rng() % 3;
+            int floor = static_cast<int>(rng() % 8) - 4;
+            RowMax expected = scalar(bottom.data(), top.data(), begin, width, mul, slope, floor);
+            RowMax actual = kernel(bottom.data(), top.data(), begin, width, mul, slope, floor);
+            assert(actual.index == expected.index);
+            if (expected.index >= 0) assert(actual.value == expected.value);
+        }
+    }
+
+    // Ties resolve to the first column; nothing above the floor gives -1.
+    std::vector<int> top = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    std::vector<int> bottom = {0, 1, 3, 2, 3, 3, 0, 3, 1, 0};
+    for (RowMaxIsa isa : {RowMaxIsa::SCALAR, RowMaxIsa::SSE41, RowMaxIsa::AVX2}) {
+        RowMaxKernel kernel = row_max_kernel(isa);
+        if (kernel == nullptr) continue;
+        RowMax row = kernel(bottom.data(), top.data(), 0, 10, 1, 0, 0);
+        assert(row.value == 3 && row.index == 2);
+        assert(kernel(bottom.data(), top.data(), 3, 10, 1, 0, 0).index == 4);
+        assert(kernel(bottom.data(), top.data(), 0, 10, 1, 0, 3).index == -1);
+    }
+    cout << "Test 46: Row max kernels passed." << endl;
+}
+
+
+void test_reusable_solver() {
+    std::mt19937 rng(59);
+    auto random_matrix = [&](int m, int n) {
+        std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n));
+        for (auto& row : matrix) {
+            for (int j = 0; j < n; ++j) row[j] = rng() % 2;
+        }
+        return matrix;
+    };
+
+    for (Strategy strategy : {Strategy::EXHAUSTIVE, Strategy::LAZY, Strategy::MAXIMAL,
+                              Strategy::CORNER}) {
+        SolveOptions options;
+        options.strategy = strategy;
+        options.dedup = strategy == Strategy::LAZY;
+        options.coarse_block = strategy == Strategy::MAXIMAL ? 4 : 0;
+        options.threads = strategy == Strategy::EXHAUSTIVE ? 4 : 1;
+        Solver solver(options);
+        assert(solver.scratch_bytes() == 0);
+
+        // Once the largest matrix has been seen no call allocates. The
+        // all-ones matrix sizes the plan for the most set cells.
+        auto big = random_matrix(30, 40);
+        assert(solver.solve(30, 40, big) == solve(30, 40, big, options));
+        size_t footprint = solver.scratch_bytes();
+        assert(footprint > 0);
+        Plan plan;
+        std::vector<std::vector<bool>> ones(30, std::vector<bool>(40, true));
+        solver.solve_with_plan(30, 40, ones, plan);
+        footprint = solver.scratch_bytes();
+        for (int trial = 0; trial < 20; ++trial) {
+            int m = 1 + rng() % 30, n = 1 + rng() % 40;
+            auto matrix = random_matrix(m, n);
+            uint64_t before = allocations;
+            int flips = solver.solve(m, n, matrix);
+            solver.solve_with_plan(m, n, matrix, plan);
+            assert(allocations == before);
+            assert(flips == solve(m, n, matrix, options));
+            Plan expected = solve_with_plan(m, n, matrix, options);
+            assert(plan.flips == expected.flips);
+            assert(verify_plan(m, n, matrix, plan.rects));
+            assert(solver.scratch_bytes() == footprint);
+        }
+
+        std::vector<uint8_t> bytes(30 * 40);
+        for (int i = 0; i < 30; ++i) {
+            for (int j = 0; j < 40; ++j) bytes[i * 40 + j] = big[i][j];
+        }
+        assert(solver.solve(ByteMatrixView{30, 40, 40, bytes.data()}) == solve(30, 40, big, options));
+        solver.release();
+        assert(solver.scratch_bytes() == 0);
+        assert(solver.solve(30, 40, big) == solve(30, 40, big, options));
+    }
+
+    Solver solver;
+    bool threw = false;
+    try {
+        solver.solve(2, 2, {{1, 0}});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    cout << "Test 47: Reusable solver passed." << endl;
+}
+
+void test_batch_stats() {
+    std::mt19937 rng(61);
+    std::vector<std::vector<std::vector<bool>>> matrices;
+    for (int t = 0; t < 40; ++t) {
+        int m = 1 + rng() % 12, n = 1 + rng() % 12;
+        std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n));
+        // Every fifth job is all zero and must not carry stats over.
+        for (auto& row : matrix) {
+            for (int j = 0; j < n; ++j) row[j] = t % 5 != 4 && rng() % 2;
+        }
+        matrices.push_back(matrix);
+    }
+
+    // Stats of the batch are the per-matrix stats summed in input order,
+    // whatever worker ran each job.
+    SolveStats expected;
+    SolveStats one;
+    SolveOptions serial;
+    serial.stats = &one;
+    for (const auto& matrix : matrices) {
+        solve((int)matrix.size(), (int)matrix[0].size(), matrix, serial);
+        expected.iterations += one.iterations;
+        expected.candidates_scanned += one.candidates_scanned;
+        expected.candidates_skipped += one.candidates_skipped;
+        expected.best_cover.insert(expected.best_cover.end(),
+                                   one.best_cover.begin(), one.best_cover.end());
+    }
+
+    SolveStats stats;
+    stats.iterations = 7;
+    SolveOptions options;
+    options.threads = 4;
+    options.stats = &stats;
+    std::vector<int> results = solve_batch(matrices, options);
+    if (STATS_ENABLED) {
+        uint64_t total = 0;
+        for (int flips : results) total += flips;
+        assert(stats.iterations == total);
+        assert(stats.iterations == expected.iterations);
+        assert(stats.candidates_scanned == expected.candidates_scanned);
+        assert(stats.candidates_skipped == expected.candidates_skipped);
+        assert(stats.best_cover == expected.best_cover);
+    } else {
+        assert(stats.iterations == 7 && stats.best_cover.empty());
+    }
+    cout << "Test 48: Batch stats passed." << endl;
+}
+
 
 int main() {
     test_all_false();
@@ -342,6 +1252,28 @@ int main() {
     test_size_mismatch_ragged();
     test_negative_dims();
     test_empty_vector_positive_dims();
+    test_block_across_word_boundary();
+    test_parallel_matches_serial();
+    test_maximal_strategy();
+    test_exact_small();
+    test_batch_in_order();
+    test_matrix_file_round_trip();
+    test_stats();
+    test_plan_replays();
+    test_lazy_matches_exhaustive();
+    test_small_specialization();
+    test_anytime_improves();
+    test_net_gain_scoring();
+    test_views_and_in_place();
+    test_corner_strategy();
+    test_sparse_coordinates();
+    test_incremental_toggles();
+    test_dedup_preprocessing();
+    test_canonical_cache();
+    test_coarse_to_fine();
+    test_row_max_kernels();
+    test_reusable_solver();
+    test_batch_stats();
 
     cout << "All tests passed." << endl;
     return 0;
@@ -0,0 +1,114 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace solution {
+
+// Fixed-size pool that runs one indexed loop at a time. The calling thread
+// takes part in every loop, so a pool of size 1 never starts a thread.
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads) {
+        if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (threads <= 0) threads = 1;
+        for (int i = 1; i < threads; ++i) {
+            workers_.emplace_back([this, i] { worker_loop(i); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+    // Call fn(task, worker) for every task in [0, tasks) and return once all
+    // of them have finished. `worker` is in [0, size()) and is stable for the
+    // duration of one call, so it can index per-worker scratch. Tasks are
+    // handed out dynamically in increasing order. fn is called by reference,
+    // never copied, so a call does not allocate.
+    template <typename Fn>
+    void parallel_for(int tasks, Fn&& fn) {
+        if (tasks <= 0) return;
+        if (workers_.empty() || tasks == 1) {
+            for (int t = 0; t < tasks; ++t) fn(t, 0);
+            return;
+        }
+        using Body = std::remove_reference_t<Fn>;
+        run(tasks, const_cast<void*>(static_cast<const void*>(std::addressof(fn))),
+            [](void* body, int task, int worker) { (*static_cast<Body*>(body))(task, worker); });
+    }
+
+private:
+    void run(int tasks, void* job, void (*call)(void*, int, int)) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = job;
+            call_ = call;
+            tasks_ = tasks;
+            next_.store(0);
+            active_ = static_cast<int>(workers_.size());
+            ++generation_;
+        }
+        wake_.notify_all();
+        drain(0);
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return active_ == 0; });
+        job_ = nullptr;
+    }
+
+    void drain(int worker) {
+        for (int t = next_.fetch_add(1); t < tasks_; t = next_.fetch_add(1)) {
+            call_(job_, t, worker);
+        }
+    }
+
+    void worker_loop(int worker) {
+        unsigned long seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+                if (stopping_) return;
+                seen = generation_;
+            }
+            drain(worker);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--active_ == 0) done_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    // Loop body of the current call, invoked as call_(job_, task, worker).
+    void* job_ = nullptr;
+    void (*call_)(void*, int, int) = nullptr;
+    int tasks_ = 0;
+    std::atomic<int> next_{0};
+    int active_ = 0;
+    unsigned long generation_ = 0;
+    bool stopping_ = false;
+};
+
+}
+
+#endif
@@ -75,6 +75,150 @@ static inline void maybe_add_horizontal(double y_side,
     out.push_back(h);
 }
 
+// ------------------------------- Wall grid ----------------------------------
+
+// Below this many walls a plain scan beats walking the grid.
+static constexpr std::size_t grid_min_walls = 32;
+// Cap on grid cells along either axis.
+static constexpr double grid_max_cells = 2048.0;
+
+static inline int grid_cell(double v, double origin, double size, int count) {
+    double c = std::floor((v - origin) / size);
+    return static_cast<int>(std::min(std::max(c, 0.0), static_cast<double>(count - 1)));
+}
+
+void ProjectilePathSimulator::build_grid() {
+    grid_dirty_ = false;
+    grid_ = WallGrid();
+    grid_.stamp.assign(walls_.size(), 0);
+    if (walls_.size() < grid_min_walls) return;    // nx == 0: always scan
+
+    double lo_x = std::numeric_limits<double>::infinity(), lo_y = lo_x;
+    double hi_x = -lo_x, hi_y = -lo_x;
+    for (const auto& w : walls_) {
+        lo_x = std::min(lo_x, w.x1); hi_x = std::max(hi_x, w.x2);
+        lo_y = std::min(lo_y, w.y1); hi_y = std::max(hi_y, w.y2);
+    }
+    if (!std::isfinite(lo_x) || !std::isfinite(lo_y) ||
+        !std::isfinite(hi_x) || !std::isfinite(hi_y)) return;
+
+    // Faces are inserted grown by `margin`, far above rounding in the walk
+    // and above any eps_face a query near the walls will ask for.
+    const double margin = 1e-9 * scale_for(lo_x, lo_y, hi_x, hi_y);
+    lo_x -= margin; lo_y -= margin;
+    hi_x += margin; hi_y += margin;
+
+    // About one cell per wall, shaped like the bounding box.
+    const double n = static_cast<double>(walls_.size());
+    const double w = hi_x - lo_x, h = hi_y - lo_y;
+    WallGrid& g = grid_;
+    g.x0 = lo_x; g.y0 = lo_y;
+    g.margin = margin;
+    g.nx = static_cast<int>(std::min(grid_max_cells, std::max(1.0, std::ceil(std::sqrt(n * w / h)))));
+    g.ny = static_cast<int>(std::min(grid_max_cells, std::max(1.0, std::ceil(std::sqrt(n * h / w)))));
+    g.cell_w = w / g.nx;
+    g.cell_h = h / g.ny;
+
+    // Each wall goes into the cells its four faces touch, once per cell,
+    // so a large rectangle costs its perimeter rather than its area.
+    const std::size_t cells = static_cast<std::size_t>(g.nx) * g.ny;
+    std::vector<int> last(cells, -1);
+    auto cover = [&](int i, auto&& visit) {
+        const Wall& wall = walls_[i];
+        const double faces[4][4] = {
+            {wall.x1, wall.y1, wall.x1, wall.y2}, {wall.x2, wall.y1, wall.x2, wall.y2},
+            {wall.x1, wall.y1, wall.x2, wall.y1}, {wall.x1, wall.y2, wall.x2, wall.y2}};
+        for (const auto& f : faces) {
+            int cx1 = grid_cell(f[0] - margin, g.x0, g.cell_w, g.nx);
+            int cx2 = grid_cell(f[2] + margin, g.x0, g.cell_w, g.nx);
+            int cy1 = grid_cell(f[1] - margin, g.y0, g.cell_h, g.ny);
+            int cy2 = grid_cell(f[3] + margin, g.y0, g.cell_h, g.ny);
+            for (int cy = cy1; cy <= cy2; ++cy) {
+                for (int cx = cx1; cx <= cx2; ++cx) {
+                    int cell = cy * g.nx + cx;
+                    if (last[cell] == i) continue;
+                    last[cell] = i;
+                    visit(cell);
+                }
+            }
+        }
+    };
+
+    const int count = static_cast<int>(walls_.size());
+    g.cell_start.assign(cells + 1, 0);
+    for (int i = 0; i < count; ++i) cover(i, [&](int cell) { ++g.cell_start[cell + 1]; });
+    for (std::size_t c = 0; c < cells; ++c) g.cell_start[c + 1] += g.cell_start[c];
+
+    std::fill(last.begin(), last.end(), -1);
+    std::vector<int> fill(g.cell_start.begin(), g.cell_start.end() - 1);
+    g.cell_walls.resize(g.cell_start.back());
+    for (int i = 0; i < count; ++i) cover(i, [&](int cell) { g.cell_walls[fill[cell]++] = i; });
+}
+
+bool ProjectilePathSimulator::walls_near(double px, double py, double dx, double dy,
+                                         double len, double pad, std::vector<int>& out) {
+    out.clear();
+    WallGrid& g = grid_;
+    if (g.nx == 0 || !(pad <= 0.5 * g.margin)) return false;
+    if (!std::isfinite(px) || !std::isfinite(py) || !std::isfinite(len)) return false;
+
+    // Clip the segment to the grid (slab test); outside it no face is near.
+    double t0 = 0.0, t1 = len;
+    auto clip = [&](double p, double d, double lo, double hi) {
+        if (d == 0.0) return p >= lo && p <= hi;
+        double a = (lo - p) / d, b = (hi - p) / d;
+        if (a > b) std::swap(a, b);
+        t0 = std::max(t0, a);
+        t1 = std::min(t1, b);
+        return t0 <= t1;
+    };
+    if (!clip(px, dx, g.x0, g.x0 + g.nx * g.cell_w)) return true;
+    if (!clip(py, dy, g.y0, g.y0 + g.ny * g.cell_h)) return true;
+
+    if (++g.query == 0) {
+        std::fill(g.stamp.begin(), g.stamp.end(), 0u);
+        g.query = 1;
+    }
+
+    // Walk the cells the segment crosses (Amanatides-Woo DDA).
+    const double inf = std::numeric_limits<double>::infinity();
+    int ix = grid_cell(px + dx * t0, g.x0, g.cell_w, g.nx);
+    int iy = grid_cell(py + dy * t0, g.y0, g.cell_h, g.ny);
+    const int step_x = dx > 0.0 ? 1 : -1;
+    const int step_y = dy > 0.0 ? 1 : -1;
+    double next_x = dx > 0.0 ? (g.x0 + (ix + 1) * g.cell_w - px) / dx
+                  : dx < 0.0 ? (g.x0 + ix * g.cell_w - px) / dx : inf;
+    double next_y = dy > 0.0 ? (g.y0 + (iy + 1) * g.cell_h - py) / dy
+                  : dy < 0.0 ? (g.y0 + iy * g.cell_h - py) / dy : inf;
+    const double delta_x = dx != 0.0 ? g.cell_w / std::fabs(dx) : inf;
+    const double delta_y = dy != 0.0 ? g.cell_h / std::fabs(dy) : inf;
+
+    for (;;) {
+        const int cell = iy * g.nx + ix;
+        for (int k = g.cell_start[cell]; k < g.cell_start[cell + 1]; ++k) {
+            const int i = g.cell_walls[k];
+            if (g.stamp[i] == g.query) continue;
+            g.stamp[i] = g.query;
+            out.push_back(i);
+        }
+        if (next_x < next_y) {
+            if (next_x > t1) break;
+            ix += step_x;
+            if (ix < 0 || ix >= g.nx) break;
+            next_x += delta_x;
+        } else {
+            if (next_y > t1) break;
+            iy += step_y;
+            if (iy < 0 || iy >= g.ny) break;
+            next_y += delta_y;
+        }
+    }
+
+    // Wall order decides tie averaging below; keep it as a full scan has it.
+    std::sort(out.begin(), out.end());
+    return true;
+}
+
 // ------------------------------ Implementation ------------------------------
 
 ProjectilePathSimulator::ProjectilePathSimulator(double speed, double distance_budget)
@@ -87,6 +231,7 @@ void ProjectilePathSimulator::add_wall(double x1, double y1, double x2, double y
     // Ignore true zero-area (single point) "walls"
     if (std::abs(x1 - x2) < 1e-12 && std::abs(y1 - y2) < 1e-12) return;
     walls_.push_back({std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2), behavior});
+    grid_dirty_ = true;
 }
 
 std::vector<std::pair<double, double>> ProjectilePathSimulator::simulatePath(
@@ -116,6 +261,7 @@ std::vector<std::pair<double, double>> ProjectilePathSimulator::simulate(
 {
     // Ensure direction is normalized even if user calls simulate directly.
     normalize(direction_x, direction_y);
+    if (grid_dirty_) build_grid();
 
     std::vector<std::pair<double, double>> path;
     path.emplace_back(start_x, start_y);
@@ -124,6 +270,7 @@ std::vector<std::pair<double, double>> ProjectilePathSimulator::simulate(
     double dx = direction_x, dy = direction_y;
 
     double remaining_budget = distance_budget_;
+    std::vector<int> nearby;    // walls near the current segment
 
     // Global numeric tolerances (scale-aware)
     auto scale_now = [&]() {
@@ -148,10 +295,10 @@ std::vector<std::pair<double, double>> ProjectilePathSimulator::simulate(
             const double eps_tie  = 128.0 * ulp * (1.0 + speed_);
             const double eps_push = 1024.0 * ulp * (1.0 + speed_);
 
-            // Gather all first-side hits among all walls within this tick distance.
+            // Gather all first-side hits among the walls near this tick's segment.
             std::vector<SideHit> candidates;
 
-            for (const auto& w : walls_) {
+            auto test_wall = [&](const Wall& w) {
                 // Vertical sides
                 if (std::abs(w.x1 - w.x2) <= 1e-12) {
                     maybe_add_vertical(w.x1, w, px, py, dx, dy, remaining_in_tick,
@@ -172,6 +319,11 @@ std::vector<std::pair<double, double>> ProjectilePathSimulator::simulate(
                     maybe_add_horizontal(w.y2, w, px, py, dx, dy, remaining_in_tick,
                                          eps_dir, eps_face, eps_d, candidates);
                 }
+            };
+            if (walls_near(px, py, dx, dy, remaining_in_tick + eps_d, eps_face, nearby)) {
+                for (int i : nearby) test_wall(walls_[i]);
+            } else {
+                for (const auto& w : walls_) test_wall(w);
             }
 
             if (candidates.empty()) {
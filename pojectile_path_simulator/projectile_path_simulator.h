@@ -38,9 +38,32 @@ public:
         const std::vector<Wall>& walls);
 
 private:
+    // Uniform grid over the walls' faces. Each cell lists, in CSR form, the
+    // walls with a face passing within `margin` of it. Rebuilt lazily by
+    // simulate() after add_wall().
+    struct WallGrid {
+        double x0 = 0.0, y0 = 0.0;
+        double cell_w = 1.0, cell_h = 1.0;
+        double margin = 0.0;
+        int nx = 0, ny = 0;
+        std::vector<int> cell_start;    // nx * ny + 1 offsets into cell_walls
+        std::vector<int> cell_walls;
+        std::vector<unsigned> stamp;    // per wall: last query that listed it
+        unsigned query = 0;
+    };
+
+    void build_grid();
+    // Indices (ascending, unique) of walls with a face within `pad` of the
+    // segment from (px, py) along the unit (dx, dy) for `len`. Returns false
+    // when the grid cannot guarantee that; the caller then scans every wall.
+    bool walls_near(double px, double py, double dx, double dy, double len, double pad,
+                    std::vector<int>& out);
+
     double speed_;
     double distance_budget_;
     std::vector<Wall> walls_;
+    WallGrid grid_;
+    bool grid_dirty_ = true;
 };
 
 } 
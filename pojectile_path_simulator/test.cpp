@@ -374,6 +374,32 @@ TEST_CASE("High-density field of pass-throughs is handled and deterministic", "[
     comparePath(path, expected);
 }
 
+TEST_CASE("Large wall field only visits walls near the path", "[performance][density][pass][index]") {
+    std::pair<double,double> start{0.0, 0.0};
+    std::pair<double,double> dir{1.0, 0.0};
+    double tick = 2.0, budget = 100.0;
+    std::vector<sim::Wall> walls;
+    for (int i = 1; i < 100; ++i) {
+        walls.push_back(makeWall(i, -1.0, i, 1.0, 'P'));
+    }
+    // 100k pass-throughs above the path that it never reaches.
+    for (int i = 0; i < 100000; ++i) {
+        double x = i % 1000, y = 5.0 + i / 1000;
+        walls.push_back(makeWall(x, y, x, y + 0.5, 'P'));
+    }
+    auto path = sim::ProjectilePathSimulator::simulatePath(start, dir, tick, budget, walls);
+    std::vector<std::pair<double,double>> expected;
+    for (int i = 0; i <= 100; ++i) expected.emplace_back(i, 0.0);
+    comparePath(path, expected);
+
+    // Walls added between calls are seen by the next one.
+    sim::ProjectilePathSimulator simulator(tick, budget);
+    for (const auto& w : walls) simulator.add_wall(w.x1, w.y1, w.x2, w.y2, w.behavior);
+    comparePath(simulator.simulate(0.0, 0.0, 1.0, 0.0), expected);
+    simulator.add_wall(2.5, -1.0, 2.5, 1.0, sim::WallBehavior::STOP);
+    comparePath(simulator.simulate(0.0, 0.0, 1.0, 0.0), {{0.0,0.0},{1.0,0.0},{2.0,0.0},{2.5,0.0}});
+}
+
 /* -----------------------------------------------------------
    Degenerate & exact boundary cases
  -----------------------------------------------------------*/